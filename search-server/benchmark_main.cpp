@@ -0,0 +1,22 @@
+#include "benchmarks.h"
+
+int main() {
+    benchmark::BenchmarkPostingLists();
+    benchmark::BenchmarkConcurrentMap();
+    benchmark::BenchmarkProcessQueriesJoined();
+    benchmark::BenchmarkFindTopDocumentsBatch();
+    benchmark::BenchmarkPostingListFormats();
+    benchmark::BenchmarkSnapshot();
+    benchmark::BenchmarkAddDocuments();
+    benchmark::BenchmarkConcurrentSearchServer();
+    benchmark::BenchmarkRemoveDuplicates();
+    benchmark::BenchmarkSplitIntoWords();
+    benchmark::BenchmarkDynamicPruning();
+    benchmark::BenchmarkRequiredWords();
+    benchmark::BenchmarkStatusPartitions();
+    benchmark::BenchmarkMatchDocuments();
+    benchmark::BenchmarkRemoveDocuments();
+    benchmark::BenchmarkShardedSearchServer();
+    benchmark::BenchmarkShardRpc();
+    return 0;
+}
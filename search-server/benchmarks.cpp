@@ -0,0 +1,717 @@
+#include "benchmarks.h"
+#include "concurrent_map.h"
+#include "concurrent_search_server.h"
+#include "process_queries.h"
+#include "shard_rpc.h"
+#include "sharded_search_server.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <atomic>
+#include <execution>
+#include <filesystem>
+#include <list>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace benchmark {
+    void PrintResult(string_view mark, double microseconds_per_query) {
+        cerr << mark << ": "sv << microseconds_per_query << " us/query"sv << endl;
+    }
+
+    namespace {
+        // Прежняя схема индекса, сохранённая только для сравнения
+        class MapIndex {
+        public:
+            explicit MapIndex(const vector<string>& documents) {
+                for (size_t id = 0; id < documents.size(); ++id) {
+                    const vector<string_view> words = SplitIntoWords(documents[id]);
+                    const double inv_word_count = 1.0 / words.size();
+                    for (const string_view word : words) {
+                        word_to_document_freqs_[word][static_cast<int>(id)] += inv_word_count;
+                    }
+                    document_ratings_[static_cast<int>(id)] = 2;
+                }
+                document_count_ = documents.size();
+            }
+
+            vector<Document> FindTopDocuments(string_view raw_query) const {
+                map<int, double> document_to_relevance;
+                vector<string_view> words = SplitIntoWords(raw_query);
+                sort(words.begin(), words.end());
+                words.erase(unique(words.begin(), words.end()), words.end());
+                for (const string_view word : words) {
+                    const auto postings = word_to_document_freqs_.find(word);
+                    if (postings == word_to_document_freqs_.end()) {
+                        continue;
+                    }
+                    const double inverse_document_freq = log(document_count_ * 1.0 / postings->second.size());
+                    for (const auto [document_id, term_freq] : postings->second) {
+                        // как и в SearchServer, рейтинг документа нужен предикату на каждой записи
+                        if (document_ratings_.at(document_id) > 0) {
+                            document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                        }
+                    }
+                }
+                vector<Document> matched_documents;
+                for (const auto [document_id, relevance] : document_to_relevance) {
+                    matched_documents.push_back({ document_id, relevance, document_ratings_.at(document_id) });
+                }
+                sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
+                    return lhs.relevance > rhs.relevance;
+                });
+                if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+                    matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+                }
+                return matched_documents;
+            }
+
+        private:
+            map<string_view, map<int, double>> word_to_document_freqs_;
+            map<int, int> document_ratings_;
+            size_t document_count_ = 0;
+        };
+    } // namespace
+
+    void BenchmarkPostingLists() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkPostingLists started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 1'000, 10);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 20'000, 70);
+        const vector<string> queries = GenerateQueries(generator, dictionary, 1'000, 10);
+
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        const MapIndex map_index(documents);
+
+        size_t found_count = 0;
+        PrintResult("nested std::map"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            found_count += map_index.FindTopDocuments(query).size();
+        }));
+        PrintResult("posting lists"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            found_count += search_server.FindTopDocuments(query).size();
+        }));
+        cerr << "found "sv << found_count << " documents"sv << endl;
+    }
+
+    void BenchmarkConcurrentMap() {
+        cerr << "BenchmarkConcurrentMap started..."sv << endl;
+        constexpr int kOperationCount = 4'000'000;
+        constexpr int kKeyCount = 100'000;
+        mt19937 generator;
+        vector<int> keys(kOperationCount);
+        for (int& key : keys) {
+            key = uniform_int_distribution<int>(0, kKeyCount - 1)(generator);
+        }
+        const unsigned max_thread_count = max(1u, thread::hardware_concurrency());
+        for (unsigned thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+            ConcurrentMap<int, double> concurrent_map(thread_count * 4);
+            const auto start_time = chrono::steady_clock::now();
+            vector<thread> threads;
+            for (unsigned t = 0; t < thread_count; ++t) {
+                threads.emplace_back([&, t] {
+                    // каждая четвёртая операция - удаление
+                    for (size_t i = t; i < keys.size(); i += thread_count) {
+                        if (i % 4 == 3) {
+                            concurrent_map.Erase(keys[i]);
+                        } else {
+                            concurrent_map[keys[i]] += 1.0;
+                        }
+                    }
+                });
+            }
+            for (thread& worker : threads) {
+                worker.join();
+            }
+            const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+            cerr << thread_count << " threads: "sv << kOperationCount / seconds / 1e6 << " Mops/s, "sv
+                << concurrent_map.Extract().size() << " keys left"sv << endl;
+        }
+    }
+
+    void BenchmarkProcessQueriesJoined() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkProcessQueriesJoined started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 2'000, 10);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 20'000, 10);
+        const vector<string> queries = GenerateQueries(generator, dictionary, 20'000, 7);
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+
+        const auto measure = [&](string_view mark, auto join) {
+            const size_t allocations_before = test::GetAllocationCount();
+            const auto start_time = chrono::steady_clock::now();
+            const size_t document_count = join();
+            const double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+            cerr << mark << ": "sv << milliseconds << " ms, "sv << test::GetAllocationCount() - allocations_before
+                << " allocations, "sv << document_count << " documents"sv << endl;
+        };
+        measure("std::list join"sv, [&] {
+            list<Document> joined;
+            for (const vector<Document>& query_documents : ProcessQueries(search_server, queries)) {
+                for (const Document& document : query_documents) {
+                    joined.push_back(document);
+                }
+            }
+            return joined.size();
+        });
+        measure("flat join"sv, [&] {
+            return ProcessQueriesJoined(search_server, queries).size();
+        });
+        measure("lazy flattening"sv, [&] {
+            const vector<vector<Document>> results = ProcessQueries(search_server, queries);
+            size_t document_count = 0;
+            for ([[maybe_unused]] const Document& document : AllFindedDocuments(results)) {
+                ++document_count;
+            }
+            return document_count;
+        });
+    }
+
+    void BenchmarkFindTopDocumentsBatch() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkFindTopDocumentsBatch started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 2'000, 10);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 50'000, 10);
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        // в узком словаре запросы пакета делят почти все слова, в широком - почти не делят
+        for (const size_t query_dictionary_size : { size_t{ 50 }, dictionary.size() }) {
+            const vector<string> query_dictionary(dictionary.begin(), dictionary.begin() + query_dictionary_size);
+            const vector<string> queries = GenerateQueries(generator, query_dictionary, 20'000, 7);
+            const string suffix = ", "s + to_string(query_dictionary_size) + " query words"s;
+            const auto measure = [&](string_view mark, auto search) {
+                const auto start_time = chrono::steady_clock::now();
+                search();
+                const auto duration = chrono::steady_clock::now() - start_time;
+                PrintResult(string(mark) + suffix, chrono::duration<double, micro>(duration).count() / static_cast<double>(queries.size()));
+            };
+            measure("transform(par) over FindTopDocuments"sv, [&] {
+                vector<vector<Document>> results(queries.size());
+                transform(execution::par, queries.begin(), queries.end(), results.begin(), [&search_server](const string& query) {
+                    return search_server.FindTopDocuments(query);
+                });
+            });
+            measure("FindTopDocumentsBatch"sv, [&] {
+                search_server.FindTopDocumentsBatch(queries);
+            });
+        }
+    }
+
+    void BenchmarkPostingListFormats() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkPostingListFormats started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 100'000, 70);
+        const vector<string> queries = GenerateQueries(generator, dictionary, 2'000, 7);
+        for (const auto& [mark, format] : { pair{ "plain"sv, PostingListFormat::PLAIN },
+                                             pair{ "compressed"sv, PostingListFormat::COMPRESSED } }) {
+            SearchServer search_server(""s, format);
+            for (size_t i = 0; i < documents.size(); ++i) {
+                search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            }
+            cerr << mark << " postings: "sv << search_server.GetPostingsMemoryUsage() / 1024 << " KiB"sv << endl;
+            PrintResult(string(mark) + " seq"s, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+                return search_server.FindTopDocuments(query);
+            }));
+            PrintResult(string(mark) + " par"s, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+                return search_server.FindTopDocuments(execution::par, query);
+            }));
+        }
+    }
+
+    void BenchmarkSnapshot() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkSnapshot started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 100'000, 70);
+        const string path = (filesystem::temp_directory_path() / "search_server_benchmark.snapshot"s).string();
+
+        auto start_time = chrono::steady_clock::now();
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        cerr << "AddDocument: "sv << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count()
+            << " ms"sv << endl;
+        search_server.SaveSnapshot(path);
+
+        start_time = chrono::steady_clock::now();
+        const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+        cerr << "LoadSnapshot: "sv << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count()
+            << " ms, "sv << filesystem::file_size(path) / 1024 << " KiB file"sv << endl;
+        filesystem::remove(path);
+    }
+
+    void BenchmarkAddDocuments() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkAddDocuments started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 100'000, 70);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+        }
+        const auto measure = [](string_view mark, auto add_documents) {
+            SearchServer search_server(""s);
+            const auto start_time = chrono::steady_clock::now();
+            add_documents(search_server);
+            cerr << mark << ": "sv << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count()
+                << " ms"sv << endl;
+        };
+        measure("AddDocument"sv, [&](SearchServer& search_server) {
+            for (const DocumentToAdd& document : documents) {
+                search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+        });
+        measure("AddDocuments(par)"sv, [&](SearchServer& search_server) {
+            search_server.AddDocuments(execution::par, documents);
+        });
+    }
+
+    void BenchmarkConcurrentSearchServer() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkConcurrentSearchServer started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 5'000, 10);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 40'000, 30);
+        const vector<string> queries = GenerateQueries(generator, dictionary, 2'000, 5);
+        constexpr size_t kInitialDocumentCount = 20'000;
+
+        // Читатель выполняет запросы, пока писатель добавляет оставшиеся документы по одному
+        const auto measure = [&](string_view mark, auto find, auto add) {
+            atomic<bool> is_writing = true;
+            thread writer([&] {
+                for (size_t i = kInitialDocumentCount; i < documents.size(); ++i) {
+                    add(static_cast<int>(i), documents[i]);
+                }
+                is_writing = false;
+            });
+            vector<double> latencies;
+            for (size_t i = 0; is_writing; i = (i + 1) % queries.size()) {
+                const auto start_time = chrono::steady_clock::now();
+                find(queries[i]);
+                latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start_time).count());
+            }
+            writer.join();
+            sort(latencies.begin(), latencies.end());
+            cerr << mark << ": median "sv << latencies[latencies.size() / 2] << " us, p99 "sv
+                << latencies[latencies.size() * 99 / 100] << " us, "sv << latencies.size() << " queries"sv << endl;
+        };
+        {
+            SearchServer search_server(""s);
+            for (size_t i = 0; i < kInitialDocumentCount; ++i) {
+                search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1 });
+            }
+            shared_mutex mutex;
+            measure("shared_mutex"sv, [&](const string& query) {
+                shared_lock lock(mutex);
+                return search_server.FindTopDocuments(query);
+            }, [&](int document_id, const string& document) {
+                unique_lock lock(mutex);
+                search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { 1 });
+            });
+        }
+        {
+            ConcurrentSearchServer search_server(""s);
+            for (size_t i = 0; i < kInitialDocumentCount; ++i) {
+                search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1 });
+            }
+            measure("ConcurrentSearchServer"sv, [&](const string& query) {
+                return search_server.FindTopDocuments(query);
+            }, [&](int document_id, const string& document) {
+                search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { 1 });
+            });
+        }
+    }
+
+    void BenchmarkRemoveDuplicates() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkRemoveDuplicates started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        vector<string> texts = GenerateQueries(generator, dictionary, 50'000, 40);
+        // каждый десятый документ повторяет слова одного из предыдущих в другом порядке
+        for (size_t i = 10; i < texts.size(); i += 10) {
+            vector<string_view> words = SplitIntoWords(texts[uniform_int_distribution<size_t>(0, i - 1)(generator)]);
+            shuffle(words.begin(), words.end(), generator);
+            texts[i].clear();
+            for (const string_view word : words) {
+                texts[i] += word;
+                texts[i] += ' ';
+            }
+        }
+        const auto make_server = [&texts] {
+            SearchServer search_server(""s);
+            for (size_t i = 0; i < texts.size(); ++i) {
+                search_server.AddDocument(static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1 });
+            }
+            return search_server;
+        };
+        const auto measure = [](string_view mark, auto remove_duplicates) {
+            const auto start_time = chrono::steady_clock::now();
+            const int removed_count = remove_duplicates();
+            cerr << mark << ": "sv << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count()
+                << " ms, removed "sv << removed_count << endl;
+        };
+        // сообщения об удалённых документах не выводятся
+        ostringstream removed_output;
+        streambuf* const cout_buffer = cout.rdbuf(removed_output.rdbuf());
+        {
+            SearchServer search_server = make_server();
+            measure("set<set<string_view>>"sv, [&search_server] {
+                set<set<string_view>> original_documents;
+                vector<int> documents_for_delete;
+                for (const int document_id : search_server) {
+                    set<string_view> words_document;
+                    for (const auto& [word, freq] : search_server.GetWordFrequencies(document_id)) {
+                        words_document.insert(word);
+                    }
+                    if (!original_documents.insert(move(words_document)).second) {
+                        documents_for_delete.push_back(document_id);
+                    }
+                }
+                for (const int id : documents_for_delete) {
+                    search_server.RemoveDocument(id);
+                }
+                return static_cast<int>(documents_for_delete.size());
+            });
+        }
+        for (const double similarity_threshold : { 1.0, 0.8 }) {
+            SearchServer search_server = make_server();
+            measure(similarity_threshold == 1.0 ? "fingerprints"sv : "fingerprints + MinHash 0.8"sv, [&] {
+                const int document_count = search_server.GetDocumentCount();
+                RemoveDuplicates(search_server, similarity_threshold);
+                return document_count - search_server.GetDocumentCount();
+            });
+        }
+        cout.rdbuf(cout_buffer);
+    }
+
+    void BenchmarkSplitIntoWords() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkSplitIntoWords started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 100'000, 70);
+        const auto measure = [&texts](string_view mark, auto split) {
+            size_t word_count = 0;
+            const auto start_time = chrono::steady_clock::now();
+            for (const string& text : texts) {
+                word_count += split(text);
+            }
+            cerr << mark << ": "sv << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count()
+                << " ms, "sv << word_count << " words"sv << endl;
+        };
+        measure("none_of + find"sv, [](string_view text) -> size_t {
+            if (any_of(text.begin(), text.end(), [](char c) { return c >= '\0' && c < ' '; })) {
+                return 0;
+            }
+            vector<string_view> words;
+            text.remove_prefix(min(text.find_first_not_of(' '), text.size()));
+            while (!text.empty()) {
+                const string_view word = text.substr(0, text.find(' '));
+                words.push_back(word);
+                text.remove_prefix(word.size());
+                text.remove_prefix(min(text.find_first_not_of(' '), text.size()));
+            }
+            return words.size();
+        });
+        vector<string_view> words;
+        measure("SplitIntoWords into a buffer"sv, [&words](string_view text) -> size_t {
+            return SplitIntoWords(text, words) ? words.size() : 0;
+        });
+    }
+
+    namespace {
+        // Тексты из min_word_count..max_word_count слов словаря с частотами по закону Ципфа, как в естественном языке
+        vector<string> GenerateZipfTexts(mt19937& generator, const vector<string>& dictionary, int text_count,
+            int min_word_count, int max_word_count, string_view word_prefix = {}) {
+            vector<double> word_weights(dictionary.size());
+            for (size_t i = 0; i < word_weights.size(); ++i) {
+                word_weights[i] = 1.0 / static_cast<double>(i + 1);
+            }
+            discrete_distribution<size_t> word_distribution(word_weights.begin(), word_weights.end());
+            vector<string> texts;
+            texts.reserve(text_count);
+            for (int i = 0; i < text_count; ++i) {
+                const int word_count = uniform_int_distribution<int>(min_word_count, max_word_count)(generator);
+                string text;
+                for (int j = 0; j < word_count; ++j) {
+                    text += word_prefix;
+                    text += dictionary[word_distribution(generator)];
+                    text.push_back(' ');
+                }
+                texts.push_back(move(text));
+            }
+            return texts;
+        }
+    } // namespace
+
+    void BenchmarkDynamicPruning() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkDynamicPruning started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> documents = GenerateZipfTexts(generator, dictionary, 100'000, 10, 70);
+        const vector<string> queries = GenerateZipfTexts(generator, dictionary, 2'000, 2, 7);
+        for (const auto& [mark, format] : { pair{ "plain"sv, PostingListFormat::PLAIN },
+                                             pair{ "compressed"sv, PostingListFormat::COMPRESSED } }) {
+            SearchServer search_server(""s, format);
+            for (size_t i = 0; i < documents.size(); ++i) {
+                search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            }
+            SearchServer::QueryContext context;
+            for (const auto& [mode, is_enabled] : { pair{ " exhaustive"sv, false }, pair{ " pruned"sv, true } }) {
+                search_server.SetDynamicPruning(is_enabled);
+                size_t posting_count = 0;
+                PrintResult(string(mark) + string(mode), MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+                    search_server.FindTopDocuments(context, query);
+                    posting_count += context.GetEvaluatedPostingCount();
+                }));
+                cerr << string(mark) + string(mode) << ": "sv << posting_count / queries.size() << " postings/query"sv << endl;
+            }
+        }
+    }
+
+    void BenchmarkRequiredWords() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkRequiredWords started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> documents = GenerateZipfTexts(generator, dictionary, 100'000, 10, 70);
+        // одни и те же слова без плюса (объединение списков) и с плюсом (пересечение)
+        mt19937 query_generator;
+        const vector<string> queries = GenerateZipfTexts(query_generator, dictionary, 2'000, 2, 4);
+        query_generator.seed(mt19937::default_seed);
+        const vector<string> required_queries = GenerateZipfTexts(query_generator, dictionary, 2'000, 2, 4, "+"sv);
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        SearchServer::QueryContext context;
+        for (const auto& [mark, mark_queries] : { pair{ "union"sv, &queries }, pair{ "intersection"sv, &required_queries } }) {
+            size_t posting_count = 0;
+            size_t found_count = 0;
+            PrintResult(mark, MeasureMicrosecondsPerQuery(*mark_queries, [&](const string& query) {
+                found_count += search_server.FindTopDocuments(context, query).size();
+                posting_count += context.GetEvaluatedPostingCount();
+            }));
+            cerr << mark << ": "sv << posting_count / mark_queries->size() << " postings/query, "sv
+                << found_count << " documents found"sv << endl;
+        }
+    }
+
+    void BenchmarkStatusPartitions() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkStatusPartitions started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> documents = GenerateZipfTexts(generator, dictionary, 100'000, 10, 70);
+        const vector<string> queries = GenerateZipfTexts(generator, dictionary, 2'000, 2, 4);
+        // один документ из ста - в статусе BANNED
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], i % 100 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+                { 1, 2, 3 });
+        }
+        size_t found_count = 0;
+        PrintResult("predicate"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            found_count += search_server.FindTopDocuments(query, [](int, DocumentStatus status, int) {
+                return status == DocumentStatus::BANNED;
+            }).size();
+        }));
+        cerr << "predicate: "sv << found_count << " documents found"sv << endl;
+        found_count = 0;
+        PrintResult("status"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            found_count += search_server.FindTopDocuments(query, DocumentStatus::BANNED).size();
+        }));
+        cerr << "status: "sv << found_count << " documents found"sv << endl;
+    }
+
+    void BenchmarkMatchDocuments() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkMatchDocuments started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> documents = GenerateZipfTexts(generator, dictionary, 100'000, 10, 70);
+        const vector<string> queries = GenerateZipfTexts(generator, dictionary, 200, 3, 6);
+        SearchServer search_server(""s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        // подсветка слов в тысяче документов страницы выдачи
+        vector<int> document_ids(1'000);
+        iota(document_ids.begin(), document_ids.end(), 0);
+        size_t matched_count = 0;
+        PrintResult("MatchDocument per id"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            for (const int document_id : document_ids) {
+                matched_count += get<0>(search_server.MatchDocument(query, document_id)).size();
+            }
+        }));
+        PrintResult("MatchDocuments seq"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            for (const auto& [words, status] : search_server.MatchDocuments(execution::seq, query, document_ids)) {
+                matched_count += words.size();
+            }
+        }));
+        PrintResult("MatchDocuments par"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            for (const auto& [words, status] : search_server.MatchDocuments(execution::par, query, document_ids)) {
+                matched_count += words.size();
+            }
+        }));
+        cerr << "matched "sv << matched_count << " words"sv << endl;
+    }
+
+    void BenchmarkRemoveDocuments() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkRemoveDocuments started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> texts = GenerateZipfTexts(generator, dictionary, 10'000, 10, 70);
+        constexpr int kRoundCount = 20;
+        constexpr int kRoundDocumentCount = 5'000;
+        constexpr int kLiveDocumentCount = 20'000;
+        // В каждом раунде добавляются новые документы и удаляются самые старые; у каждого документа
+        // есть собственное слово, список которого пустеет вместе с документом
+        const auto measure = [&](string_view mark, auto remove_documents) {
+            SearchServer search_server(""s);
+            double remove_milliseconds = 0.0;
+            int next_id = 0;
+            for (int round = 0; round < kRoundCount; ++round) {
+                vector<string> round_texts;
+                vector<DocumentToAdd> documents;
+                for (int i = 0; i < kRoundDocumentCount; ++i) {
+                    round_texts.push_back(texts[(next_id + i) % texts.size()] + " id"s + to_string(next_id + i));
+                }
+                for (int i = 0; i < kRoundDocumentCount; ++i, ++next_id) {
+                    documents.push_back({ next_id, round_texts[i], DocumentStatus::ACTUAL, { 1 } });
+                }
+                search_server.AddDocuments(execution::par, documents);
+                if (next_id <= kLiveDocumentCount) {
+                    continue;
+                }
+                vector<int> document_ids(kRoundDocumentCount);
+                iota(document_ids.begin(), document_ids.end(), next_id - kLiveDocumentCount - kRoundDocumentCount);
+                const auto start_time = chrono::steady_clock::now();
+                remove_documents(search_server, document_ids);
+                remove_milliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+            }
+            cerr << mark << ": "sv << remove_milliseconds << " ms, postings "sv
+                << search_server.GetPostingsMemoryUsage() / 1024 << " KiB"sv << endl;
+        };
+        measure("RemoveDocument"sv, [](SearchServer& search_server, const vector<int>& document_ids) {
+            for (const int document_id : document_ids) {
+                search_server.RemoveDocument(document_id);
+            }
+        });
+        measure("RemoveDocuments(seq)"sv, [](SearchServer& search_server, const vector<int>& document_ids) {
+            search_server.RemoveDocuments(execution::seq, document_ids);
+        });
+        measure("RemoveDocuments(par)"sv, [](SearchServer& search_server, const vector<int>& document_ids) {
+            search_server.RemoveDocuments(execution::par, document_ids);
+        });
+    }
+
+    void BenchmarkShardedSearchServer() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkShardedSearchServer started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> texts = GenerateZipfTexts(generator, dictionary, 100'000, 10, 70);
+        const vector<string> queries = GenerateZipfTexts(generator, dictionary, 2'000, 2, 7);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+        }
+        SearchServer search_server(""s);
+        search_server.AddDocuments(execution::par, documents);
+        PrintResult("SearchServer seq"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            search_server.FindTopDocuments(execution::seq, query);
+        }));
+        PrintResult("SearchServer par"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            search_server.FindTopDocuments(execution::par, query);
+        }));
+        const set<size_t> shard_counts = { 2, max(1u, thread::hardware_concurrency()) };
+        for (const size_t shard_count : shard_counts) {
+            ShardedSearchServer sharded_server(shard_count, ""s);
+            const auto start_time = chrono::steady_clock::now();
+            sharded_server.AddDocuments(documents);
+            cerr << shard_count << " shards: added in "sv
+                << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count() << " ms"sv << endl;
+            PrintResult(to_string(shard_count) + " shards"s, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+                sharded_server.FindTopDocuments(query);
+            }));
+        }
+    }
+
+    void BenchmarkShardRpc() {
+        using namespace test::test_policies;
+        cerr << "BenchmarkShardRpc started..."sv << endl;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 10'000, 10);
+        const vector<string> texts = GenerateZipfTexts(generator, dictionary, 50'000, 10, 70);
+        const vector<string> queries = GenerateZipfTexts(generator, dictionary, 2'000, 2, 7);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+        }
+        SearchServer search_server(""s);
+        search_server.AddDocuments(documents);
+        PrintResult("SearchServer in process"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+            search_server.FindTopDocuments(query);
+        }));
+
+        constexpr size_t SHARD_COUNT = 2;
+        vector<string> socket_paths;
+        vector<unique_ptr<SearchServer>> shards;
+        vector<thread> shard_threads;
+        for (size_t shard = 0; shard < SHARD_COUNT; ++shard) {
+            socket_paths.push_back((filesystem::temp_directory_path() / ("search_server_benchmark_shard_"s + to_string(shard) + ".sock"s)).string());
+            shards.push_back(make_unique<SearchServer>(""s));
+            shard_threads.emplace_back(ServeShard, ref(*shards.back()), socket_paths.back());
+        }
+        {
+            ShardCoordinator coordinator(socket_paths);
+            auto start_time = chrono::steady_clock::now();
+            coordinator.AddDocuments(documents);
+            cerr << SHARD_COUNT << " shards over sockets: added in "sv
+                << chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count() << " ms"sv << endl;
+            // задержка: каждый запрос ждёт ответов всех шардов
+            PrintResult("FindTopDocuments over sockets"sv, MeasureMicrosecondsPerQuery(queries, [&](const string& query) {
+                coordinator.FindTopDocuments(query);
+            }));
+            // пропускная способность: запросы уходят окнами без ожидания ответов
+            start_time = chrono::steady_clock::now();
+            coordinator.FindTopDocumentsBatch(queries);
+            PrintResult("FindTopDocumentsBatch over sockets"sv,
+                chrono::duration<double, micro>(chrono::steady_clock::now() - start_time).count() / queries.size());
+            coordinator.Shutdown();
+        }
+        for (thread& shard_thread : shard_threads) {
+            shard_thread.join();
+        }
+    }
+} // namespace benchmark
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace benchmark {
+    // Средняя задержка на один вызов function(query) в микросекундах
+    template <typename Function>
+    double MeasureMicrosecondsPerQuery(const std::vector<std::string>& queries, Function function) {
+        const auto start_time = std::chrono::steady_clock::now();
+        for (const std::string& query : queries) {
+            function(query);
+        }
+        const auto duration = std::chrono::steady_clock::now() - start_time;
+        return std::chrono::duration<double, std::micro>(duration).count() / static_cast<double>(queries.size());
+    }
+
+    void PrintResult(std::string_view mark, double microseconds_per_query);
+
+    // Плоские списки документов против прежней схемы std::map<std::string_view, std::map<int, double>>
+    void BenchmarkPostingLists();
+
+    // Масштабирование ConcurrentMap от одного потока до числа ядер
+    void BenchmarkConcurrentMap();
+
+    // Количество выделений памяти и время ProcessQueriesJoined против прежнего объединения в std::list
+    void BenchmarkProcessQueriesJoined();
+
+    // Пакет запросов: прежний transform(par) по FindTopDocuments против FindTopDocumentsBatch
+    // на запросах с общими и с различными словами
+    void BenchmarkFindTopDocumentsBatch();
+
+    // Память и задержка поиска для несжатых и сжатых списков документов
+    void BenchmarkPostingListFormats();
+
+    // Время запуска: индексация корпуса заново против загрузки снимка
+    void BenchmarkSnapshot();
+
+    // Индексация по одному документу против пакетного AddDocuments
+    void BenchmarkAddDocuments();
+
+    // Задержка поиска во время добавления документов: внешний shared_mutex против ConcurrentSearchServer
+    void BenchmarkConcurrentSearchServer();
+
+    // Поиск дубликатов: прежний set<set<string_view>> против отпечатков номеров слов и MinHash
+    void BenchmarkRemoveDuplicates();
+
+    // Разбиение на слова: проверка символов и find по каждому слову против однопроходного векторного разбора
+    void BenchmarkSplitIntoWords();
+
+    // Поиск лучших документов: полный перебор списков против отсечения MaxScore, задержка и число оценённых записей
+    void BenchmarkDynamicPruning();
+
+    // Запросы из одних и тех же слов: объединение списков против пересечения списков обязательных слов
+    void BenchmarkRequiredWords();
+
+    // Поиск документов редкого статуса: предикат по всем спискам слов против обхода документов статуса
+    void BenchmarkStatusPartitions();
+
+    // Подсветка слов запроса в тысяче документов: MatchDocument по каждому id против одного вызова MatchDocuments
+    void BenchmarkMatchDocuments();
+
+    // Поток добавлений и удалений: RemoveDocument по каждому id против RemoveDocuments, время удаления и память списков
+    void BenchmarkRemoveDocuments();
+
+    // Поиск в одном SearchServer (seq и par) против ShardedSearchServer на двух шардах и на шарде на ядро
+    void BenchmarkShardedSearchServer();
+
+    // Шарды за сокетами Unix: задержка FindTopDocuments и пропускная способность конвейера FindTopDocumentsBatch
+    // против поиска в SearchServer того же процесса
+    void BenchmarkShardRpc();
+} // namespace benchmark
@@ -1,32 +1,48 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
-#include <future>
 #include <map>
-#include <numeric>
-#include <random>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <mutex>
-#include <iterator>
 
 using namespace std::string_literals;
 
 template <typename Key, typename Value>
 class ConcurrentMap {
-    // ,     mutex
-    struct SubMap {
+    enum class SlotState : uint8_t {
+        EMPTY,
+        OCCUPIED,
+        ERASED,
+    };
+
+    struct Slot {
+        Key key{};
+        Value value{};
+        SlotState state = SlotState::EMPTY;
+    };
+
+    // ,     mutex.
+    //  - -   ,   -,
+    //         
+    struct alignas(64) SubMap {
         std::mutex mtx;
-        std::map<Key, Value> concurrent_map;
+        std::vector<Slot> slots;
+        size_t size = 0;
+        size_t erased_count = 0;
     };
+
 public:
     static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
 
     struct Access {
-        Access(SubMap& sum_map, const Key key)
-            : guard(sum_map.mtx)
-            , ref_to_value(sum_map.concurrent_map[key]) {
+        Access(SubMap& sub_map, const Key key)
+            : guard(sub_map.mtx)
+            , ref_to_value(FindOrInsert(sub_map, key)) {
         }
 
         void operator+=(const Value& other) {
@@ -38,27 +54,141 @@ public:
     };
 
     explicit ConcurrentMap(size_t bucket_count)
-        : sub_maps_(bucket_count) {
+        : sub_maps_(std::max<size_t>(bucket_count, 1)) {
     }
 
     Access operator[](const Key& key) {
-        SubMap& one_sub_map = sub_maps_[static_cast<uint64_t>(key) % sub_maps_.size()];
-        return { one_sub_map, key };
+        return { GetSubMap(key), key };
     }
 
-    std::map<Key, Value> BuildOrdinaryMap() {
-        std::map<Key, Value> result;
-        for (auto& [mtx, concurrent_map] : sub_maps_) {
-            std::lock_guard guard(mtx);
-            result.insert(concurrent_map.begin(), concurrent_map.end());
+    void Erase(const Key& key) {
+        SubMap& sub_map = GetSubMap(key);
+        std::lock_guard guard(sub_map.mtx);
+        Slot* slot = Find(sub_map, key);
+        if (slot != nullptr) {
+            slot->state = SlotState::ERASED;
+            slot->value = Value{};
+            --sub_map.size;
+            ++sub_map.erased_count;
+        }
+    }
+
+    //   (, )  ,    .    
+    template <typename Function>
+    void ForEach(Function function) {
+        for (SubMap& sub_map : sub_maps_) {
+            std::lock_guard guard(sub_map.mtx);
+            for (Slot& slot : sub_map.slots) {
+                if (slot.state == SlotState::OCCUPIED) {
+                    function(static_cast<const Key&>(slot.key), slot.value);
+                }
+            }
+        }
+    }
+
+    //          .    
+    std::vector<std::pair<Key, Value>> Extract() {
+        std::vector<std::pair<Key, Value>> result;
+        for (SubMap& sub_map : sub_maps_) {
+            std::lock_guard guard(sub_map.mtx);
+            result.reserve(result.size() + sub_map.size);
+            for (Slot& slot : sub_map.slots) {
+                if (slot.state == SlotState::OCCUPIED) {
+                    result.emplace_back(slot.key, std::move(slot.value));
+                }
+            }
+            sub_map.slots.clear();
+            sub_map.size = 0;
+            sub_map.erased_count = 0;
         }
         return result;
     }
 
-    void Erase(const Key& key) {
-        sub_maps_[static_cast<uint64_t>(key) % sub_maps_.size()].concurrent_map.erase(key);
+    std::map<Key, Value> BuildOrdinaryMap() {
+        std::map<Key, Value> result;
+        ForEach([&result](const Key& key, const Value& value) {
+            result.emplace(key, value);
+        });
+        return result;
     }
 
 private:
     std::vector<SubMap> sub_maps_;
+
+    //    ( MurmurHash3):    ,
+    //  - ,          
+    static uint64_t Hash(const Key& key) {
+        uint64_t hash = static_cast<uint64_t>(key);
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    SubMap& GetSubMap(const Key& key) {
+        return sub_maps_[(Hash(key) >> 32) % sub_maps_.size()];
+    }
+
+    static Slot* Find(SubMap& sub_map, const Key& key) {
+        if (sub_map.slots.empty()) {
+            return nullptr;
+        }
+        const size_t mask = sub_map.slots.size() - 1;
+        for (size_t index = Hash(key) & mask;; index = (index + 1) & mask) {
+            Slot& slot = sub_map.slots[index];
+            if (slot.state == SlotState::EMPTY) {
+                return nullptr;
+            }
+            if (slot.state == SlotState::OCCUPIED && slot.key == key) {
+                return &slot;
+            }
+        }
+    }
+
+    static Value& FindOrInsert(SubMap& sub_map, const Key& key) {
+        if (Slot* slot = Find(sub_map, key)) {
+            return slot->value;
+        }
+        //        ,   
+        if ((sub_map.size + sub_map.erased_count + 1) * 2 > sub_map.slots.size()) {
+            Rehash(sub_map);
+        }
+        const size_t mask = sub_map.slots.size() - 1;
+        size_t index = Hash(key) & mask;
+        while (sub_map.slots[index].state == SlotState::OCCUPIED) {
+            index = (index + 1) & mask;
+        }
+        Slot& slot = sub_map.slots[index];
+        if (slot.state == SlotState::ERASED) {
+            --sub_map.erased_count;
+        }
+        slot.key = key;
+        slot.value = Value{};
+        slot.state = SlotState::OCCUPIED;
+        ++sub_map.size;
+        return slot.value;
+    }
+
+    static void Rehash(SubMap& sub_map) {
+        size_t capacity = 16;
+        while (capacity < (sub_map.size + 1) * 4) {
+            capacity *= 2;
+        }
+        std::vector<Slot> old_slots(capacity);
+        old_slots.swap(sub_map.slots);
+        const size_t mask = capacity - 1;
+        for (Slot& old_slot : old_slots) {
+            if (old_slot.state != SlotState::OCCUPIED) {
+                continue;
+            }
+            size_t index = Hash(old_slot.key) & mask;
+            while (sub_map.slots[index].state == SlotState::OCCUPIED) {
+                index = (index + 1) & mask;
+            }
+            sub_map.slots[index] = std::move(old_slot);
+        }
+        sub_map.erased_count = 0;
+    }
 };
@@ -0,0 +1,62 @@
+#include "concurrent_search_server.h"
+
+#include <functional>
+#include <thread>
+
+using namespace std;
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& search_server) {
+        return search_server.GetDocumentCount();
+    });
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, const string_view document, DocumentStatus status,
+    const vector<int>& ratings) {
+    Write([&](SearchServer& search_server) {
+        search_server.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& search_server) {
+        search_server.RemoveDocument(document_id);
+    });
+}
+
+void ConcurrentSearchServer::ReadIndicator::Arrive(size_t slot) {
+    slots_[slot].reader_count.fetch_add(1);
+}
+
+void ConcurrentSearchServer::ReadIndicator::Depart(size_t slot) {
+    slots_[slot].reader_count.fetch_sub(1);
+}
+
+bool ConcurrentSearchServer::ReadIndicator::IsEmpty() const {
+    for (const Slot& slot : slots_) {
+        if (slot.reader_count.load() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ConcurrentSearchServer::GetReaderSlot() {
+    thread_local const size_t slot = hash<thread::id>{}(this_thread::get_id()) % ReadIndicator::SLOT_COUNT;
+    return slot;
+}
+
+void ConcurrentSearchServer::WaitForReaders() {
+    // Читатель отмечается на счётчике до того, как узнаёт опубликованный экземпляр. Поэтому после
+    // переключения новых читателей на другой счётчик и опустошения обоих счётчиков ни один читатель
+    // не может работать со скрытым экземпляром
+    const int previous_index = read_indicator_index_.load();
+    const int next_index = 1 - previous_index;
+    while (!read_indicators_[next_index].IsEmpty()) {
+        this_thread::yield();
+    }
+    read_indicator_index_.store(next_index);
+    while (!read_indicators_[previous_index].IsEmpty()) {
+        this_thread::yield();
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "search_server.h"
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// SearchServer для одновременных чтений и записей (схема left-right).
+// Сервер хранится в двух экземплярах: читатели работают с опубликованным, писатель изменяет скрытый,
+// публикует его одной атомарной записью, дожидается ухода читателей прежнего экземпляра и повторяет
+// изменение на нём. Читатели не ждут писателей и видят неизменную версию индекса на всё время чтения.
+// Цена - двойная память и двойная работа записи; записи выполняются по одной
+class ConcurrentSearchServer {
+public:
+    // Оба экземпляра строятся из одних и тех же аргументов конструктора SearchServer
+    template <typename... Args>
+    explicit ConcurrentSearchServer(const Args&... args);
+
+    ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+    ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+
+    // Вызывает function(const SearchServer&) над опубликованной версией индекса.
+    // Результат не должен ссылаться на сервер после возврата
+    template <typename Function>
+    auto Read(Function function) const;
+    // Применяет function(SearchServer&) к обоим экземплярам по очереди, поэтому она должна давать
+    // одинаковый результат на одинаковых серверах. Исключение из function публикуется вместе с изменениями,
+    // сделанными до него, и пробрасывается вызывающему
+    template <typename Function>
+    void Write(Function function);
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(const Args&... args) const;
+    template <typename... Args>
+    SearchServer::words_and_status_document MatchDocument(const Args&... args) const;
+    template <typename... Args>
+    std::vector<SearchServer::words_and_status_document> MatchDocuments(const Args&... args) const;
+    int GetDocumentCount() const;
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    template <typename... Args>
+    void AddDocuments(const Args&... args);
+    void RemoveDocument(int document_id);
+    template <typename... Args>
+    void RemoveDocuments(const Args&... args);
+
+private:
+    // Счётчик читателей, разбитый на полосы, чтобы читатели разных потоков не делили одну кеш-линию
+    class ReadIndicator {
+    public:
+        static constexpr size_t SLOT_COUNT = 16;
+
+        void Arrive(size_t slot);
+        void Depart(size_t slot);
+        bool IsEmpty() const;
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<int> reader_count{ 0 };
+        };
+        Slot slots_[SLOT_COUNT];
+    };
+
+    SearchServer left_;
+    SearchServer right_;
+    SearchServer* const instances_[2] = { &left_, &right_ };
+    // экземпляр, который видят читатели
+    std::atomic<int> published_instance_{ 0 };
+    // счётчик, на котором отмечаются новые читатели
+    std::atomic<int> read_indicator_index_{ 0 };
+    mutable ReadIndicator read_indicators_[2];
+    std::mutex write_mutex_;
+
+    static size_t GetReaderSlot();
+    // Дожидается ухода всех читателей, которые могли видеть экземпляр до публикации
+    void WaitForReaders();
+};
+
+template <typename... Args>
+ConcurrentSearchServer::ConcurrentSearchServer(const Args&... args)
+    : left_(args...)
+    , right_(args...) {
+}
+
+template <typename Function>
+auto ConcurrentSearchServer::Read(Function function) const {
+    const int indicator_index = read_indicator_index_.load();
+    const size_t slot = GetReaderSlot();
+    ReadIndicator& indicator = read_indicators_[indicator_index];
+    indicator.Arrive(slot);
+    struct DepartGuard {
+        ReadIndicator& indicator;
+        size_t slot;
+        ~DepartGuard() {
+            indicator.Depart(slot);
+        }
+    } guard{ indicator, slot };
+    return function(static_cast<const SearchServer&>(*instances_[published_instance_.load()]));
+}
+
+template <typename Function>
+void ConcurrentSearchServer::Write(Function function) {
+    std::lock_guard guard(write_mutex_);
+    const int published = published_instance_.load();
+    std::exception_ptr error;
+    try {
+        function(*instances_[1 - published]);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    published_instance_.store(1 - published);
+    WaitForReaders();
+    try {
+        function(*instances_[published]);
+    } catch (...) {
+        // то же исключение уже получено от первого экземпляра
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+template <typename... Args>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(const Args&... args) const {
+    return Read([&](const SearchServer& search_server) {
+        return search_server.FindTopDocuments(args...);
+    });
+}
+
+template <typename... Args>
+SearchServer::words_and_status_document ConcurrentSearchServer::MatchDocument(const Args&... args) const {
+    return Read([&](const SearchServer& search_server) {
+        return search_server.MatchDocument(args...);
+    });
+}
+
+template <typename... Args>
+std::vector<SearchServer::words_and_status_document> ConcurrentSearchServer::MatchDocuments(const Args&... args) const {
+    return Read([&](const SearchServer& search_server) {
+        return search_server.MatchDocuments(args...);
+    });
+}
+
+template <typename... Args>
+void ConcurrentSearchServer::AddDocuments(const Args&... args) {
+    Write([&](SearchServer& search_server) {
+        search_server.AddDocuments(args...);
+    });
+}
+
+template <typename... Args>
+void ConcurrentSearchServer::RemoveDocuments(const Args&... args) {
+    Write([&](SearchServer& search_server) {
+        search_server.RemoveDocuments(args...);
+    });
+}
@@ -0,0 +1,56 @@
+#include "corpus_statistics.h"
+
+#include <cassert>
+
+using namespace std;
+
+void CorpusStatistics::AddDocument(const vector<string_view>& words) {
+    for (const string_view word : words) {
+        const TermId term = terms_.Intern(word);
+        if (term >= document_freqs_.size()) {
+            document_freqs_.resize(term + 1, 0);
+        }
+        ++document_freqs_[term];
+    }
+    ++document_count_;
+    ++version_;
+}
+
+void CorpusStatistics::RemoveDocument(const vector<string_view>& words) {
+    for (const string_view word : words) {
+        const TermId term = terms_.Find(word);
+        assert(term != TermDictionary::NO_TERM && document_freqs_[term] > 0);
+        --document_freqs_[term];
+    }
+    --document_count_;
+    ++version_;
+}
+
+void CorpusStatistics::SetDocumentFreqs(int document_count, const vector<pair<string_view, uint32_t>>& document_freqs) {
+    bool is_changed = document_count != document_count_;
+    document_count_ = document_count;
+    for (const auto& [word, document_freq] : document_freqs) {
+        const TermId term = terms_.Intern(word);
+        if (term >= document_freqs_.size()) {
+            document_freqs_.resize(term + 1, 0);
+        }
+        is_changed = is_changed || document_freqs_[term] != document_freq;
+        document_freqs_[term] = document_freq;
+    }
+    if (is_changed) {
+        ++version_;
+    }
+}
+
+int CorpusStatistics::GetDocumentCount() const {
+    return document_count_;
+}
+
+uint32_t CorpusStatistics::GetDocumentFreq(string_view word) const {
+    const TermId term = terms_.Find(word);
+    return term == TermDictionary::NO_TERM ? 0 : document_freqs_[term];
+}
+
+uint64_t CorpusStatistics::GetVersion() const {
+    return version_;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "term_dictionary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Число документов и число документов с каждым словом в корпусе, разделённом между несколькими серверами.
+// Серверы, подключённые к статистике, вычисляют IDF по ней, а не по своим документам, поэтому релевантность
+// документа не зависит от того, какому серверу он достался. Изменения не должны идти одновременно с поиском
+class CorpusStatistics {
+public:
+    // words - различные слова документа без стоп-слов
+    void AddDocument(const std::vector<std::string_view>& words);
+    void RemoveDocument(const std::vector<std::string_view>& words);
+    // Заменяет число документов и частоты перечисленных слов значениями, вычисленными в другом месте,
+    // например координатором шардов. Версия меняется, только если значения изменились
+    void SetDocumentFreqs(int document_count, const std::vector<std::pair<std::string_view, uint32_t>>& document_freqs);
+
+    int GetDocumentCount() const;
+    // 0 для слова, которого нет ни в одном документе
+    uint32_t GetDocumentFreq(std::string_view word) const;
+    // Меняется при каждом изменении статистики
+    uint64_t GetVersion() const;
+
+private:
+    TermDictionary terms_;
+    // число документов с каждым словом, индекс - номер слова
+    std::vector<uint32_t> document_freqs_;
+    int document_count_ = 0;
+    uint64_t version_ = 1;
+};
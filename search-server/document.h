@@ -1,5 +1,7 @@
 #pragma once
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 using namespace std::string_literals;
 
@@ -19,4 +21,12 @@ struct Document {
     int rating = 0;
 };
 
+// Документ для пакетного добавления. Текст принадлежит вызывающему и нужен только на время добавления
+struct DocumentToAdd {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 std::ostream& operator <<(std::ostream& output, const Document& document);
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "index_segment.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+IndexSegment::IndexSegment(int begin_ordinal, int end_ordinal, vector<pair<TermId, PostingList>> postings)
+    : begin_ordinal_(begin_ordinal)
+    , end_ordinal_(end_ordinal) {
+    terms_.reserve(postings.size());
+    postings_.reserve(postings.size());
+    for (auto& [term, term_postings] : postings) {
+        assert(terms_.empty() || terms_.back() < term);
+        terms_.push_back(term);
+        postings_.push_back(move(term_postings));
+    }
+}
+
+IndexSegment IndexSegment::Merge(const vector<const IndexSegment*>& segments, const vector<bool>& removed_ordinals) {
+    assert(!segments.empty());
+    // слова всех сегментов по возрастанию, затем списки каждого слова подряд по сегментам
+    vector<TermId> terms;
+    for (const IndexSegment* segment : segments) {
+        terms.insert(terms.end(), segment->terms_.begin(), segment->terms_.end());
+    }
+    sort(terms.begin(), terms.end());
+    terms.erase(unique(terms.begin(), terms.end()), terms.end());
+
+    vector<pair<TermId, PostingList>> postings;
+    postings.reserve(terms.size());
+    vector<size_t> positions(segments.size(), 0);
+    vector<const PostingList*> term_postings;
+    for (const TermId term : terms) {
+        term_postings.clear();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const IndexSegment& segment = *segments[i];
+            if (positions[i] < segment.terms_.size() && segment.terms_[positions[i]] == term) {
+                term_postings.push_back(&segment.postings_[positions[i]]);
+                ++positions[i];
+            }
+        }
+        PostingList merged = PostingList::Concatenate(term_postings, removed_ordinals);
+        if (!merged.IsEmpty()) {
+            postings.emplace_back(term, move(merged));
+        }
+    }
+    return IndexSegment(segments.front()->begin_ordinal_, segments.back()->end_ordinal_, move(postings));
+}
+
+int IndexSegment::GetBeginOrdinal() const {
+    return begin_ordinal_;
+}
+
+int IndexSegment::GetEndOrdinal() const {
+    return end_ordinal_;
+}
+
+const PostingList* IndexSegment::FindPostings(TermId term) const {
+    const auto it = lower_bound(terms_.begin(), terms_.end(), term);
+    if (it == terms_.end() || *it != term) {
+        return nullptr;
+    }
+    return &postings_[it - terms_.begin()];
+}
+
+size_t IndexSegment::GetMemoryUsage() const {
+    size_t memory_usage = sizeof(IndexSegment) + terms_.capacity() * sizeof(TermId);
+    for (const PostingList& postings : postings_) {
+        memory_usage += postings.GetMemoryUsage();
+    }
+    return memory_usage + (postings_.capacity() - postings_.size()) * sizeof(PostingList);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "posting_list.h"
+#include "term_dictionary.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Запечатанный сегмент индекса: неизменяемые списки документов слов для документов
+// с номерами из [begin_ordinal, end_ordinal). Удалённые документы остаются в списках сегмента,
+// сервер отмечает их в битовой карте, а слияние сегментов их отбрасывает
+class IndexSegment {
+public:
+    // postings - непустые списки, упорядоченные по номеру слова
+    IndexSegment(int begin_ordinal, int end_ordinal, std::vector<std::pair<TermId, PostingList>> postings);
+
+    // Сливает соседние сегменты, перечисленные в порядке номеров документов
+    static IndexSegment Merge(const std::vector<const IndexSegment*>& segments, const std::vector<bool>& removed_ordinals);
+
+    int GetBeginOrdinal() const;
+    int GetEndOrdinal() const;
+    // Список документов слова или nullptr, если слова в сегменте нет
+    const PostingList* FindPostings(TermId term) const;
+    size_t GetMemoryUsage() const;
+
+private:
+    int begin_ordinal_;
+    int end_ordinal_;
+    // номера слов по возрастанию и их списки
+    std::vector<TermId> terms_;
+    std::vector<PostingList> postings_;
+};
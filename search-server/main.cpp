@@ -48,6 +48,27 @@ void RunExample() {
 int main() {
     test::test_policies::TestPolicies();
     test::TestFind();
+    test::TestRemoveDocument();
+    test::TestConcurrentMap();
+    test::TestQueryCache();
+    test::TestProcessQueries();
+    test::TestPostingListFormats();
+    test::TestSnapshot();
+    test::TestAddDocuments();
+    test::TestConcurrentSearchServer();
+    test::TestSegments();
+    test::TestRemoveDuplicates();
+    test::TestSplitIntoWords();
+    test::TestQueryContext();
+    test::TestInverseDocumentFreqCache();
+    test::TestDynamicPruning();
+    test::TestRequiredWords();
+    test::TestStatusPartitions();
+    test::TestMatchDocuments();
+    test::TestRemoveDocuments();
+    test::TestDocumentIdOrder();
+    test::TestShardedSearchServer();
+    test::TestShardRpc();
     RunExample();
     system("pause");
     return 0;
@@ -0,0 +1,68 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SEARCH_SERVER_HAS_MMAP
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) {
+#ifdef SEARCH_SERVER_HAS_MMAP
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw runtime_error("Cannot open file "s + path);
+    }
+    struct stat file_status;
+    if (fstat(descriptor, &file_status) != 0) {
+        close(descriptor);
+        throw runtime_error("Cannot read the size of file "s + path);
+    }
+    size_ = static_cast<size_t>(file_status.st_size);
+    if (size_ > 0) {
+        void* const data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            throw runtime_error("Cannot map file "s + path);
+        }
+        data_ = static_cast<const char*>(data);
+        is_mapped_ = true;
+    }
+    // отображение остаётся действительным и после закрытия дескриптора
+    close(descriptor);
+#else
+    ifstream input(path, ios::binary | ios::ate);
+    if (!input) {
+        throw runtime_error("Cannot open file "s + path);
+    }
+    size_ = static_cast<size_t>(input.tellg());
+    buffer_ = make_unique<char[]>(size_);
+    input.seekg(0);
+    if (!input.read(buffer_.get(), static_cast<streamsize>(size_))) {
+        throw runtime_error("Cannot read file "s + path);
+    }
+    data_ = buffer_.get();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef SEARCH_SERVER_HAS_MMAP
+    if (is_mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+const char* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Файл, отображённый в память только для чтения. Страницы отображения общие для всех процессов,
+// открывших тот же файл. Без POSIX mmap файл читается в память целиком
+class MappedFile {
+public:
+    // Бросает std::runtime_error, если файл не удалось открыть или отобразить
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Начало данных выровнено не хуже, чем на 8 байт
+    const char* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool is_mapped_ = false;
+    std::unique_ptr<char[]> buffer_;
+};
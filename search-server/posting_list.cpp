@@ -0,0 +1,377 @@
+#include "posting_list.h"
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std;
+
+PostingList::PostingList(PostingListFormat format)
+    : format_(format) {
+}
+
+void PostingList::Add(int ordinal, uint32_t term_count, uint32_t word_count) {
+    assert(term_count > 0 && term_count <= word_count);
+    Materialize();
+    if (format_ == PostingListFormat::PLAIN) {
+        assert(ordinals_.empty() || ordinals_.back() < ordinal);
+        ordinals_.push_back(ordinal);
+        term_freqs_.push_back(ComputeTermFreq(term_count, word_count));
+        UpdateMaxTermFreqs(term_freqs_.back());
+        ++size_;
+        return;
+    }
+    assert(last_ordinal_ < ordinal);
+    if (size_ % BLOCK_SIZE == 0) {
+        blocks_.push_back({ ordinal, static_cast<uint32_t>(bytes_.size()) });
+        last_ordinal_ = ordinal;
+    }
+    UpdateMaxTermFreqs(ComputeTermFreq(term_count, word_count));
+    AppendVarint(bytes_, static_cast<uint32_t>(ordinal - last_ordinal_));
+    AppendVarint(bytes_, term_count);
+    AppendVarint(bytes_, word_count);
+    last_ordinal_ = ordinal;
+    ++size_;
+}
+
+bool PostingList::Remove(int ordinal) {
+    if (!Contains(ordinal)) {
+        return false;
+    }
+    Materialize();
+    if (format_ == PostingListFormat::PLAIN) {
+        term_freqs_[FindPosition(ordinal)] = REMOVED_TERM_FREQ;
+    } else {
+        // ноль дополняется байтами продолжения до прежней длины, чтобы не сдвигать следующие записи
+        size_t i = FindTermCountOffset(ordinal);
+        for (; bytes_[i] & 0x80; ++i) {
+            bytes_[i] = 0x80;
+        }
+        bytes_[i] = 0;
+    }
+    ++removed_count_;
+    if (NeedsCompaction()) {
+        Compact();
+    }
+    return true;
+}
+
+bool PostingList::Contains(int ordinal) const {
+    if (format_ == PostingListFormat::PLAIN) {
+        const size_t position = FindPosition(ordinal);
+        return position != size_ && GetTermFreqs()[position] != REMOVED_TERM_FREQ;
+    }
+    const size_t offset = FindTermCountOffset(ordinal);
+    if (offset == GetByteCount()) {
+        return false;
+    }
+    const uint8_t* position = GetBytes() + offset;
+    return ReadVarint(position) != 0;
+}
+
+size_t PostingList::GetDocumentCount() const {
+    return size_ - removed_count_;
+}
+
+bool PostingList::IsEmpty() const {
+    return GetDocumentCount() == 0;
+}
+
+PostingListFormat PostingList::GetFormat() const {
+    return format_;
+}
+
+double PostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+size_t PostingList::GetMemoryUsage() const {
+    return sizeof(PostingList) + ordinals_.capacity() * sizeof(int) + term_freqs_.capacity() * sizeof(double)
+        + bytes_.capacity() + blocks_.capacity() * sizeof(Block) + block_max_term_freqs_.capacity() * sizeof(double);
+}
+
+void PostingList::Save(SnapshotWriter& writer) const {
+    writer.Write<uint32_t>(static_cast<uint32_t>(format_));
+    writer.Write<uint64_t>(size_);
+    writer.Write<uint64_t>(removed_count_);
+    writer.Write<int32_t>(last_ordinal_);
+    writer.Write<double>(max_term_freq_);
+    writer.WriteArray(GetBlockMaxTermFreqs(), (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    if (format_ == PostingListFormat::PLAIN) {
+        writer.WriteArray(GetOrdinals(), size_);
+        writer.WriteArray(GetTermFreqs(), size_);
+    } else {
+        writer.WriteArray(GetBytes(), GetByteCount());
+        writer.WriteArray(GetBlocks(), GetBlockCount());
+    }
+}
+
+PostingList PostingList::Load(SnapshotReader& reader, size_t ordinal_count) {
+    const uint32_t format = reader.Read<uint32_t>();
+    if (format > static_cast<uint32_t>(PostingListFormat::COMPRESSED)) {
+        throw invalid_argument("The snapshot contains an unknown posting list format."s);
+    }
+    PostingList postings(static_cast<PostingListFormat>(format));
+    postings.size_ = static_cast<size_t>(reader.Read<uint64_t>());
+    postings.removed_count_ = static_cast<size_t>(reader.Read<uint64_t>());
+    postings.last_ordinal_ = reader.Read<int32_t>();
+    postings.max_term_freq_ = reader.Read<double>();
+    postings.is_mapped_ = true;
+    size_t count = 0;
+    postings.mapped_.block_max_term_freqs = reader.ReadArray<double>(count);
+    if (count != (postings.size_ + BLOCK_SIZE - 1) / BLOCK_SIZE) {
+        throw invalid_argument("The snapshot is truncated or corrupted."s);
+    }
+    if (postings.format_ == PostingListFormat::PLAIN) {
+        postings.mapped_.ordinals = reader.ReadArray<int>(count);
+        const size_t ordinal_count = count;
+        postings.mapped_.term_freqs = reader.ReadArray<double>(count);
+        if (ordinal_count != postings.size_ || count != postings.size_) {
+            throw invalid_argument("The snapshot is truncated or corrupted."s);
+        }
+    } else {
+        postings.mapped_.bytes = reader.ReadArray<uint8_t>(postings.mapped_.byte_count);
+        postings.mapped_.blocks = reader.ReadArray<Block>(postings.mapped_.block_count);
+        if (postings.mapped_.block_count != (postings.size_ + BLOCK_SIZE - 1) / BLOCK_SIZE) {
+            throw invalid_argument("The snapshot is truncated or corrupted."s);
+        }
+    }
+    postings.Validate(ordinal_count);
+    return postings;
+}
+
+void PostingList::Validate(size_t ordinal_count) const {
+    const auto check = [](bool condition) {
+        if (!condition) {
+            throw invalid_argument("The snapshot is truncated or corrupted."s);
+        }
+    };
+    check(removed_count_ <= size_);
+    // границы частот нужны отсечению, поэтому они должны быть не меньше частот записей
+    const double* block_max_term_freqs = GetBlockMaxTermFreqs();
+    const auto check_term_freq = [&](size_t i, double term_freq) {
+        check(term_freq >= 0.0 && term_freq <= 1.0 && term_freq <= block_max_term_freqs[i / BLOCK_SIZE]
+            && term_freq <= max_term_freq_);
+    };
+    size_t removed_count = 0;
+    int64_t previous_ordinal = -1;
+    if (format_ == PostingListFormat::PLAIN) {
+        const int* ordinals = GetOrdinals();
+        const double* term_freqs = GetTermFreqs();
+        for (size_t i = 0; i < size_; ++i) {
+            check(ordinals[i] > previous_ordinal && static_cast<size_t>(ordinals[i]) < ordinal_count);
+            check_term_freq(i, term_freqs[i]);
+            removed_count += term_freqs[i] == REMOVED_TERM_FREQ ? 1 : 0;
+            previous_ordinal = ordinals[i];
+        }
+        check(removed_count == removed_count_);
+        return;
+    }
+    // блоки идут в байтах подряд, а первая запись блока хранит нулевую разность от его first_ordinal
+    const Block* blocks = GetBlocks();
+    const uint8_t* bytes = GetBytes();
+    const uint8_t* const end = bytes + GetByteCount();
+    const uint8_t* position = bytes;
+    int64_t ordinal = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (i % BLOCK_SIZE == 0) {
+            const Block& block = blocks[i / BLOCK_SIZE];
+            check(bytes + block.offset == position);
+            ordinal = block.first_ordinal;
+        }
+        uint32_t delta = 0;
+        uint32_t term_count = 0;
+        uint32_t word_count = 0;
+        check(ReadVarint(position, end, delta) && ReadVarint(position, end, term_count) && ReadVarint(position, end, word_count));
+        check((delta == 0) == (i % BLOCK_SIZE == 0));
+        ordinal += delta;
+        check(ordinal > previous_ordinal && static_cast<uint64_t>(ordinal) < ordinal_count);
+        if (term_count == 0) {
+            ++removed_count;
+        } else {
+            check(term_count <= word_count);
+            check_term_freq(i, ComputeTermFreq(term_count, word_count));
+        }
+        previous_ordinal = ordinal;
+    }
+    check(position == end && removed_count == removed_count_ && last_ordinal_ == previous_ordinal);
+}
+
+void PostingList::Compact() {
+    Materialize();
+    if (format_ == PostingListFormat::PLAIN) {
+        // границы частот пересчитываются по оставшимся записям
+        block_max_term_freqs_.clear();
+        max_term_freq_ = 0.0;
+        const size_t old_size = size_;
+        size_ = 0;
+        for (size_t i = 0; i < old_size; ++i) {
+            if (term_freqs_[i] != REMOVED_TERM_FREQ) {
+                ordinals_[size_] = ordinals_[i];
+                term_freqs_[size_] = term_freqs_[i];
+                UpdateMaxTermFreqs(term_freqs_[i]);
+                ++size_;
+            }
+        }
+        ordinals_.resize(size_);
+        term_freqs_.resize(size_);
+        ordinals_.shrink_to_fit();
+        term_freqs_.shrink_to_fit();
+        block_max_term_freqs_.shrink_to_fit();
+        removed_count_ = 0;
+        return;
+    }
+    // сжатый список перекодируется заново
+    vector<tuple<int, uint32_t, uint32_t>> postings;
+    postings.reserve(GetDocumentCount());
+    const uint8_t* position = bytes_.data();
+    int ordinal = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (i % BLOCK_SIZE == 0) {
+            ordinal = blocks_[i / BLOCK_SIZE].first_ordinal;
+        }
+        ordinal += static_cast<int>(ReadVarint(position));
+        const uint32_t term_count = ReadVarint(position);
+        const uint32_t word_count = ReadVarint(position);
+        if (term_count != 0) {
+            postings.emplace_back(ordinal, term_count, word_count);
+        }
+    }
+    PostingList compacted(format_);
+    for (const auto& [posting_ordinal, term_count, word_count] : postings) {
+        compacted.Add(posting_ordinal, term_count, word_count);
+    }
+    compacted.bytes_.shrink_to_fit();
+    compacted.blocks_.shrink_to_fit();
+    compacted.block_max_term_freqs_.shrink_to_fit();
+    *this = move(compacted);
+}
+
+PostingList PostingList::Concatenate(const vector<const PostingList*>& lists, const vector<bool>& removed_ordinals) {
+    assert(!lists.empty());
+    PostingList result(lists.front()->format_);
+    for (const PostingList* postings : lists) {
+        assert(postings->format_ == result.format_);
+        if (result.format_ == PostingListFormat::PLAIN) {
+            const int* ordinals = postings->GetOrdinals();
+            const double* term_freqs = postings->GetTermFreqs();
+            for (size_t i = 0; i < postings->size_; ++i) {
+                if (term_freqs[i] != REMOVED_TERM_FREQ && !removed_ordinals[ordinals[i]]) {
+                    assert(result.ordinals_.empty() || result.ordinals_.back() < ordinals[i]);
+                    result.ordinals_.push_back(ordinals[i]);
+                    result.term_freqs_.push_back(term_freqs[i]);
+                    result.UpdateMaxTermFreqs(term_freqs[i]);
+                    ++result.size_;
+                }
+            }
+            continue;
+        }
+        const Block* blocks = postings->GetBlocks();
+        const uint8_t* position = postings->GetBytes();
+        int ordinal = 0;
+        for (size_t i = 0; i < postings->size_; ++i) {
+            if (i % BLOCK_SIZE == 0) {
+                ordinal = blocks[i / BLOCK_SIZE].first_ordinal;
+                position = postings->GetBytes() + blocks[i / BLOCK_SIZE].offset;
+            }
+            ordinal += static_cast<int>(ReadVarint(position));
+            const uint32_t term_count = ReadVarint(position);
+            const uint32_t word_count = ReadVarint(position);
+            if (term_count != 0 && !removed_ordinals[ordinal]) {
+                result.Add(ordinal, term_count, word_count);
+            }
+        }
+    }
+    result.ordinals_.shrink_to_fit();
+    result.term_freqs_.shrink_to_fit();
+    result.bytes_.shrink_to_fit();
+    result.blocks_.shrink_to_fit();
+    result.block_max_term_freqs_.shrink_to_fit();
+    return result;
+}
+
+void PostingList::Materialize() {
+    if (!is_mapped_) {
+        return;
+    }
+    if (format_ == PostingListFormat::PLAIN) {
+        ordinals_.assign(mapped_.ordinals, mapped_.ordinals + size_);
+        term_freqs_.assign(mapped_.term_freqs, mapped_.term_freqs + size_);
+    } else {
+        bytes_.assign(mapped_.bytes, mapped_.bytes + mapped_.byte_count);
+        blocks_.assign(mapped_.blocks, mapped_.blocks + mapped_.block_count);
+    }
+    block_max_term_freqs_.assign(mapped_.block_max_term_freqs, mapped_.block_max_term_freqs + (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    mapped_ = {};
+    is_mapped_ = false;
+}
+
+size_t PostingList::FindPosition(int ordinal) const {
+    const int* ordinals = GetOrdinals();
+    const int* it = lower_bound(ordinals, ordinals + size_, ordinal);
+    if (it == ordinals + size_ || *it != ordinal) {
+        return size_;
+    }
+    return static_cast<size_t>(it - ordinals);
+}
+
+size_t PostingList::FindTermCountOffset(int ordinal) const {
+    const Block* blocks = GetBlocks();
+    const Block* next_block = upper_bound(blocks, blocks + GetBlockCount(), ordinal, [](int ordinal, const Block& block) {
+        return ordinal < block.first_ordinal;
+    });
+    if (next_block == blocks) {
+        return GetByteCount();
+    }
+    const size_t block = static_cast<size_t>(next_block - blocks) - 1;
+    const uint8_t* bytes = GetBytes();
+    const uint8_t* position = bytes + blocks[block].offset;
+    int current_ordinal = blocks[block].first_ordinal;
+    const size_t block_end = min(size_, (block + 1) * BLOCK_SIZE);
+    for (size_t i = block * BLOCK_SIZE; i < block_end; ++i) {
+        current_ordinal += static_cast<int>(ReadVarint(position));
+        if (current_ordinal > ordinal) {
+            break;
+        }
+        if (current_ordinal == ordinal) {
+            return static_cast<size_t>(position - bytes);
+        }
+        ReadVarint(position);
+        ReadVarint(position);
+    }
+    return GetByteCount();
+}
+
+void PostingList::UpdateMaxTermFreqs(double term_freq) {
+    if (size_ % BLOCK_SIZE == 0) {
+        block_max_term_freqs_.push_back(term_freq);
+    } else {
+        block_max_term_freqs_.back() = max(block_max_term_freqs_.back(), term_freq);
+    }
+    max_term_freq_ = max(max_term_freq_, term_freq);
+}
+
+bool PostingList::NeedsCompaction() const {
+    return removed_count_ * 2 > size_;
+}
+
+bool PostingList::ReadVarint(const uint8_t*& position, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && position != end; shift += 7) {
+        const uint8_t byte = *position++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PostingList::AppendVarint(vector<uint8_t>& bytes, uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
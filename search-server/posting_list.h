@@ -0,0 +1,381 @@
+#pragma once
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Способ хранения списков документов, выбирается при создании сервера
+enum class PostingListFormat {
+    // номера документов и частоты в несжатых массивах
+    PLAIN,
+    // разности номеров, числа вхождений слова и длины документов в кодировке varint
+    COMPRESSED,
+};
+
+// Список документов, содержащих слово: возрастающие порядковые номера документов
+// и частоты слова в этих документах.
+// Удалённый документ помечается нулевой частотой (tombstone) и вычищается при уплотнении.
+// Список, загруженный из снимка, читает записи прямо из отображённого файла
+// и копирует их в собственные массивы при первом изменении
+class PostingList {
+public:
+    // Частота слова в документе всегда положительна, поэтому ноль свободен под метку удаления
+    static constexpr double REMOVED_TERM_FREQ = 0.0;
+
+    explicit PostingList(PostingListFormat format = PostingListFormat::PLAIN);
+
+    // Частота слова, встретившегося term_count раз в документе из word_count слов.
+    // Оба формата вычисляют её одинаково, поэтому результаты поиска не зависят от формата
+    static double ComputeTermFreq(uint32_t term_count, uint32_t word_count);
+
+    // Номера выдаются документам по возрастанию, поэтому новый документ всегда попадает в конец
+    void Add(int ordinal, uint32_t term_count, uint32_t word_count);
+    // Возвращает false, если документа в списке нет
+    bool Remove(int ordinal);
+    bool Contains(int ordinal) const;
+
+    size_t GetDocumentCount() const;
+    bool IsEmpty() const;
+    PostingListFormat GetFormat() const;
+    // Байты, занятые списком, включая зарезервированные. Записи в отображённом файле не учитываются
+    size_t GetMemoryUsage() const;
+
+    void Save(SnapshotWriter& writer) const;
+    // Список ссылается на данные reader, которые должны жить дольше списка. Записи проверяются целиком:
+    // номера документов должны возрастать и быть меньше ordinal_count, иначе бросается std::invalid_argument
+    static PostingList Load(SnapshotReader& reader, size_t ordinal_count);
+
+    // Удаляет помеченные документы из массивов
+    void Compact();
+    // Список из записей lists подряд без удалённых и отмеченных в removed_ordinals.
+    // Списки должны быть одного формата, номера каждого следующего - больше номеров предыдущего
+    static PostingList Concatenate(const std::vector<const PostingList*>& lists, const std::vector<bool>& removed_ordinals);
+
+    // Обход неудалённых документов в порядке возрастания номеров
+    template <typename Function>
+    void ForEach(Function function) const;
+    // То же для документов с номерами из [begin_ordinal, end_ordinal)
+    template <typename Function>
+    void ForEach(int begin_ordinal, int end_ordinal, Function function) const;
+
+    // Наибольшая частота слова в документах списка. Удаление записей её не уменьшает,
+    // но она остаётся верхней границей частоты
+    double GetMaxTermFreq() const;
+
+    class Cursor;
+
+private:
+    // Записи обоих форматов разбиты на блоки по BLOCK_SIZE. Разности номеров сжатого списка отсчитываются
+    // от начала блока, поэтому поиск номера декодирует не больше одного блока.
+    // Для каждого блока хранится наибольшая частота слова в нём
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    struct Block {
+        int first_ordinal;
+        uint32_t offset;
+    };
+
+    PostingListFormat format_;
+    // записей, включая помеченные удалёнными
+    size_t size_ = 0;
+    size_t removed_count_ = 0;
+
+    // PLAIN
+    std::vector<int> ordinals_;
+    std::vector<double> term_freqs_;
+
+    // COMPRESSED: запись - varint(разность номеров), varint(число вхождений), varint(число слов документа).
+    // Удалённая запись получает число вхождений 0, записанное в те же байты
+    std::vector<uint8_t> bytes_;
+    std::vector<Block> blocks_;
+    int last_ordinal_ = -1;
+
+    std::vector<double> block_max_term_freqs_;
+    double max_term_freq_ = 0.0;
+
+    // Записи списка, загруженного из снимка
+    struct MappedRecords {
+        const int* ordinals = nullptr;
+        const double* term_freqs = nullptr;
+        const uint8_t* bytes = nullptr;
+        size_t byte_count = 0;
+        const Block* blocks = nullptr;
+        size_t block_count = 0;
+        const double* block_max_term_freqs = nullptr;
+    };
+    MappedRecords mapped_;
+    bool is_mapped_ = false;
+
+    const int* GetOrdinals() const;
+    const double* GetTermFreqs() const;
+    const uint8_t* GetBytes() const;
+    size_t GetByteCount() const;
+    const Block* GetBlocks() const;
+    size_t GetBlockCount() const;
+    const double* GetBlockMaxTermFreqs() const;
+    // Копирует записи из снимка в собственные массивы перед изменением
+    void Materialize();
+    // Учитывает частоту записи, добавляемой в конец, в границах блока и списка
+    void UpdateMaxTermFreqs(double term_freq);
+
+    // Проверяет записи, загруженные из снимка, и бросает std::invalid_argument, если они повреждены
+    void Validate(size_t ordinal_count) const;
+
+    size_t FindPosition(int ordinal) const;
+    // Смещение числа вхождений записи с номером ordinal в байтах списка или GetByteCount(), если записи нет
+    size_t FindTermCountOffset(int ordinal) const;
+    // Уплотнение запускается, когда удалённых записей становится больше половины
+    bool NeedsCompaction() const;
+
+    static void AppendVarint(std::vector<uint8_t>& bytes, uint32_t value);
+    static uint32_t ReadVarint(const uint8_t*& position);
+    // То же с проверкой границы end и длины числа; false, если число повреждено
+    static bool ReadVarint(const uint8_t*& position, const uint8_t* end, uint32_t& value);
+};
+
+// Проход по неудалённым записям в порядке возрастания номеров с переходом вперёд к нужному номеру.
+// Список не должен меняться, пока курсор используется
+class PostingList::Cursor {
+public:
+    explicit Cursor(const PostingList& postings);
+
+    bool IsEnd() const;
+    int GetOrdinal() const;
+    double GetTermFreq() const;
+    void Next();
+    // Переходит к первой записи с номером не меньше ordinal
+    void SkipTo(int ordinal);
+    // Верхняя граница частоты слова в документе ordinal по наибольшей частоте его блока. Курсор не сдвигается.
+    // Номера в последовательных вызовах не должны убывать
+    double GetBlockMaxTermFreq(int ordinal);
+
+private:
+    PostingListFormat format_;
+    size_t size_;
+    const int* ordinals_;
+    const double* term_freqs_;
+    const uint8_t* bytes_;
+    const Block* blocks_;
+    size_t block_count_;
+    const double* block_max_term_freqs_;
+
+    size_t index_ = 0;
+    int ordinal_ = 0;
+    double term_freq_ = 0.0;
+    // COMPRESSED: начало записи, следующей за текущей
+    const uint8_t* position_ = nullptr;
+    // блок, найденный последним вызовом GetBlockMaxTermFreq
+    size_t bound_block_ = 0;
+
+    int GetFirstOrdinal(size_t block) const;
+    // Встаёт на первую неудалённую запись, начиная с index_
+    void Load();
+};
+
+inline double PostingList::ComputeTermFreq(uint32_t term_count, uint32_t word_count) {
+    return static_cast<double>(term_count) / static_cast<double>(word_count);
+}
+
+inline uint32_t PostingList::ReadVarint(const uint8_t*& position) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *position++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+inline const int* PostingList::GetOrdinals() const {
+    return is_mapped_ ? mapped_.ordinals : ordinals_.data();
+}
+
+inline const double* PostingList::GetTermFreqs() const {
+    return is_mapped_ ? mapped_.term_freqs : term_freqs_.data();
+}
+
+inline const uint8_t* PostingList::GetBytes() const {
+    return is_mapped_ ? mapped_.bytes : bytes_.data();
+}
+
+inline size_t PostingList::GetByteCount() const {
+    return is_mapped_ ? mapped_.byte_count : bytes_.size();
+}
+
+inline const PostingList::Block* PostingList::GetBlocks() const {
+    return is_mapped_ ? mapped_.blocks : blocks_.data();
+}
+
+inline size_t PostingList::GetBlockCount() const {
+    return is_mapped_ ? mapped_.block_count : blocks_.size();
+}
+
+inline const double* PostingList::GetBlockMaxTermFreqs() const {
+    return is_mapped_ ? mapped_.block_max_term_freqs : block_max_term_freqs_.data();
+}
+
+inline PostingList::Cursor::Cursor(const PostingList& postings)
+    : format_(postings.format_)
+    , size_(postings.size_)
+    , ordinals_(postings.GetOrdinals())
+    , term_freqs_(postings.GetTermFreqs())
+    , bytes_(postings.GetBytes())
+    , blocks_(postings.GetBlocks())
+    , block_count_((postings.size_ + BLOCK_SIZE - 1) / BLOCK_SIZE)
+    , block_max_term_freqs_(postings.GetBlockMaxTermFreqs()) {
+    Load();
+}
+
+inline bool PostingList::Cursor::IsEnd() const {
+    return index_ >= size_;
+}
+
+inline int PostingList::Cursor::GetOrdinal() const {
+    return ordinal_;
+}
+
+inline double PostingList::Cursor::GetTermFreq() const {
+    return term_freq_;
+}
+
+inline void PostingList::Cursor::Next() {
+    ++index_;
+    Load();
+}
+
+inline void PostingList::Cursor::SkipTo(int ordinal) {
+    if (IsEnd() || ordinal_ >= ordinal) {
+        return;
+    }
+    if (format_ == PostingListFormat::PLAIN) {
+        // экспоненциальный поиск от текущей записи: ordinals_[low - 1] < ordinal <= ordinals_[high]
+        size_t low = index_ + 1;
+        size_t high = low;
+        for (size_t step = 1; high < size_ && ordinals_[high] < ordinal; step *= 2) {
+            low = high + 1;
+            high += step;
+        }
+        high = std::min(high, size_);
+        index_ = static_cast<size_t>(std::lower_bound(ordinals_ + low, ordinals_ + high, ordinal) - ordinals_);
+        Load();
+        return;
+    }
+    const size_t block = index_ / BLOCK_SIZE;
+    if (block + 1 < block_count_ && blocks_[block + 1].first_ordinal <= ordinal) {
+        // последний блок, начинающийся не позже ordinal
+        const Block* next_block = std::upper_bound(blocks_ + block + 1, blocks_ + block_count_, ordinal,
+            [](int ordinal, const Block& block) {
+                return ordinal < block.first_ordinal;
+            });
+        index_ = static_cast<size_t>(next_block - blocks_ - 1) * BLOCK_SIZE;
+        Load();
+    } else {
+        Next();
+    }
+    while (!IsEnd() && ordinal_ < ordinal) {
+        Next();
+    }
+}
+
+inline double PostingList::Cursor::GetBlockMaxTermFreq(int ordinal) {
+    if (IsEnd() || ordinal < ordinal_) {
+        return 0.0;
+    }
+    if (ordinal == ordinal_) {
+        return term_freq_;
+    }
+    bound_block_ = std::max(bound_block_, index_ / BLOCK_SIZE);
+    while (bound_block_ + 1 < block_count_ && GetFirstOrdinal(bound_block_ + 1) <= ordinal) {
+        ++bound_block_;
+    }
+    return block_max_term_freqs_[bound_block_];
+}
+
+inline int PostingList::Cursor::GetFirstOrdinal(size_t block) const {
+    return format_ == PostingListFormat::PLAIN ? ordinals_[block * BLOCK_SIZE] : blocks_[block].first_ordinal;
+}
+
+inline void PostingList::Cursor::Load() {
+    if (format_ == PostingListFormat::PLAIN) {
+        while (index_ < size_ && term_freqs_[index_] == REMOVED_TERM_FREQ) {
+            ++index_;
+        }
+        if (index_ < size_) {
+            ordinal_ = ordinals_[index_];
+            term_freq_ = term_freqs_[index_];
+        }
+        return;
+    }
+    for (; index_ < size_; ++index_) {
+        if (index_ % BLOCK_SIZE == 0) {
+            const Block& block = blocks_[index_ / BLOCK_SIZE];
+            ordinal_ = block.first_ordinal;
+            position_ = bytes_ + block.offset;
+        }
+        ordinal_ += static_cast<int>(ReadVarint(position_));
+        const uint32_t term_count = ReadVarint(position_);
+        const uint32_t word_count = ReadVarint(position_);
+        if (term_count != 0) {
+            term_freq_ = ComputeTermFreq(term_count, word_count);
+            return;
+        }
+    }
+}
+
+template <typename Function>
+void PostingList::ForEach(Function function) const {
+    if (format_ == PostingListFormat::COMPRESSED) {
+        ForEach(std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), function);
+        return;
+    }
+    const int* ordinals = GetOrdinals();
+    const double* term_freqs = GetTermFreqs();
+    for (size_t i = 0; i < size_; ++i) {
+        if (term_freqs[i] != REMOVED_TERM_FREQ) {
+            function(ordinals[i], term_freqs[i]);
+        }
+    }
+}
+
+template <typename Function>
+void PostingList::ForEach(int begin_ordinal, int end_ordinal, Function function) const {
+    if (format_ == PostingListFormat::PLAIN) {
+        const int* ordinals = GetOrdinals();
+        const double* term_freqs = GetTermFreqs();
+        const size_t first = static_cast<size_t>(std::lower_bound(ordinals, ordinals + size_, begin_ordinal) - ordinals);
+        for (size_t i = first; i < size_ && ordinals[i] < end_ordinal; ++i) {
+            if (term_freqs[i] != REMOVED_TERM_FREQ) {
+                function(ordinals[i], term_freqs[i]);
+            }
+        }
+        return;
+    }
+    const Block* blocks = GetBlocks();
+    const size_t block_count = GetBlockCount();
+    // последний блок, начинающийся не позже begin_ordinal
+    const Block* next_block = std::upper_bound(blocks, blocks + block_count, begin_ordinal,
+        [](int ordinal, const Block& block) {
+            return ordinal < block.first_ordinal;
+        });
+    size_t block = next_block == blocks ? 0 : static_cast<size_t>(next_block - blocks) - 1;
+    for (; block < block_count; ++block) {
+        const uint8_t* position = GetBytes() + blocks[block].offset;
+        int ordinal = blocks[block].first_ordinal;
+        const size_t block_end = std::min(size_, (block + 1) * BLOCK_SIZE);
+        for (size_t i = block * BLOCK_SIZE; i < block_end; ++i) {
+            ordinal += static_cast<int>(ReadVarint(position));
+            const uint32_t term_count = ReadVarint(position);
+            const uint32_t word_count = ReadVarint(position);
+            if (ordinal >= end_ordinal) {
+                return;
+            }
+            if (term_count != 0 && ordinal >= begin_ordinal) {
+                function(ordinal, ComputeTermFreq(term_count, word_count));
+            }
+        }
+    }
+}
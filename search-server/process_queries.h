@@ -1,39 +1,100 @@
 #pragma once
 
 #include "search_server.h"
+#include "query_results.h"
 #include <vector>
 #include <string>
-#include <list>
 #include <algorithm>
 #include <execution>
+#include <iterator>
+#include <numeric>
 
-template <typename Iterator>
+// Ленивый обход документов всех запросов подряд: документы не копируются, память под элементы не выделяется
 class AllFindedDocuments {
 public:
-    AllFindedDocuments() = default;
+    using OuterIterator = std::vector<std::vector<Document>>::const_iterator;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator() = default;
+
+        Iterator(OuterIterator outer, OuterIterator outer_end)
+            : outer_(outer)
+            , outer_end_(outer_end) {
+            SkipEmpty();
+        }
+
+        reference operator*() const {
+            return (*outer_)[inner_];
+        }
+
+        pointer operator->() const {
+            return &(*outer_)[inner_];
+        }
+
+        Iterator& operator++() {
+            ++inner_;
+            SkipEmpty();
+            return *this;
+        }
 
-    AllFindedDocuments(const std::vector<std::vector<Document>>& finded_documents) {
-        for (const std::vector<Document>& documents_one_query : finded_documents) {
-            for (const Document& document : documents_one_query) {
-                all_finded_documents_.push_back(&document);
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return outer_ == other.outer_ && inner_ == other.inner_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        OuterIterator outer_;
+        OuterIterator outer_end_;
+        size_t inner_ = 0;
+
+        // переход к следующему непустому результату запроса
+        void SkipEmpty() {
+            while (outer_ != outer_end_ && inner_ == outer_->size()) {
+                ++outer_;
+                inner_ = 0;
             }
         }
+    };
+
+    AllFindedDocuments() = default;
+
+    explicit AllFindedDocuments(const std::vector<std::vector<Document>>& finded_documents)
+        : begin_(finded_documents.begin(), finded_documents.end())
+        , end_(finded_documents.end(), finded_documents.end()) {
     }
 
-    Iterator begin() {
-        return all_finded_documents_.begin();
+    Iterator begin() const {
+        return begin_;
     }
 
-    Iterator end() {
-        return all_finded_documents_.end();
+    Iterator end() const {
+        return end_;
     }
 
 private:
-    std::list<Iterator> all_finded_documents_;
+    Iterator begin_;
+    Iterator end_;
 };
 
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
-std::list<Document> ProcessQueriesJoined(const SearchServer& search_server, 
-    const std::vector<std::string>& queries);
\ No newline at end of file
+// Документы всех запросов в одном непрерывном буфере, без выделения памяти под каждый документ
+QueryResults ProcessQueriesJoined(const SearchServer& search_server,
+    const std::vector<std::string>& queries);
@@ -0,0 +1,101 @@
+#include "query_cache.h"
+#include "string_processing.h"
+
+using namespace std;
+
+QueryCache::QueryCache(size_t memory_limit)
+    : memory_limit_(memory_limit) {
+}
+
+optional<vector<Document>> QueryCache::Find(const string& key, uint64_t idf_version) {
+    lock_guard guard(mutex_);
+    const auto it = entries_by_key_.find(key);
+    if (it == entries_by_key_.end()) {
+        ++stats_.misses;
+        return nullopt;
+    }
+    const EntryIterator entry = it->second;
+    if (entry->idf_version != idf_version) {
+        ++stats_.invalidations;
+        ++stats_.misses;
+        Erase(entry);
+        return nullopt;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, entry);
+    return entry->documents;
+}
+
+void QueryCache::Insert(string key, uint64_t idf_version, vector<Document> documents) {
+    lock_guard guard(mutex_);
+    if (entries_by_key_.count(key) > 0) {
+        // тот же запрос мог быть вычислен параллельно в другом потоке
+        return;
+    }
+    entries_.push_front({ move(key), idf_version, move(documents), {}, 0 });
+    const EntryIterator entry = entries_.begin();
+    const vector<string_view> words = SplitIntoWords(entry->key);
+    for (auto word = next(words.begin()); word != words.end(); ++word) {
+        entry->words.push_back(word->front() == '-' || word->front() == '+' ? word->substr(1) : *word);
+    }
+    // приблизительный учёт: сами данные и узлы обоих индексов
+    constexpr size_t NODE_OVERHEAD = 4 * sizeof(void*);
+    entry->memory_usage = sizeof(Entry) + NODE_OVERHEAD + entry->key.capacity()
+        + entry->documents.capacity() * sizeof(Document)
+        + entry->words.capacity() * sizeof(string_view)
+        + entry->words.size() * (sizeof(string_view) + sizeof(EntryIterator) + NODE_OVERHEAD);
+
+    entries_by_key_.emplace(entry->key, entry);
+    for (const string_view word : entry->words) {
+        entries_by_word_.emplace(word, entry);
+    }
+    stats_.memory_usage += entry->memory_usage;
+    ++stats_.entry_count;
+
+    while (stats_.memory_usage > memory_limit_ && !entries_.empty()) {
+        ++stats_.evictions;
+        Erase(prev(entries_.end()));
+    }
+}
+
+void QueryCache::Invalidate(string_view word) {
+    lock_guard guard(mutex_);
+    auto [begin, end] = entries_by_word_.equal_range(word);
+    while (begin != end) {
+        const EntryIterator entry = begin->second;
+        ++stats_.invalidations;
+        Erase(entry);
+        // Erase удаляет элементы entries_by_word_, поэтому диапазон ищется заново
+        tie(begin, end) = entries_by_word_.equal_range(word);
+    }
+}
+
+void QueryCache::Clear() {
+    lock_guard guard(mutex_);
+    entries_by_word_.clear();
+    entries_by_key_.clear();
+    entries_.clear();
+    stats_.entry_count = 0;
+    stats_.memory_usage = 0;
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+    lock_guard guard(mutex_);
+    return stats_;
+}
+
+void QueryCache::Erase(EntryIterator entry) {
+    for (const string_view word : entry->words) {
+        auto [begin, end] = entries_by_word_.equal_range(word);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second == entry) {
+                entries_by_word_.erase(it);
+                break;
+            }
+        }
+    }
+    entries_by_key_.erase(entry->key);
+    stats_.memory_usage -= entry->memory_usage;
+    --stats_.entry_count;
+    entries_.erase(entry);
+}
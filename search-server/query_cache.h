@@ -0,0 +1,62 @@
+#pragma once
+#include "document.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct QueryCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    // вытеснены из-за бюджета памяти
+    size_t evictions = 0;
+    // устарели после изменения индекса
+    size_t invalidations = 0;
+    size_t entry_count = 0;
+    size_t memory_usage = 0;
+};
+
+// LRU-кеш результатов поиска.
+// Ключ - нормализованный запрос: первое слово - произвольный заголовок (статус, количество документов),
+// далее слова запроса через пробел, обязательные слова начинаются с '+', минус-слова - с '-'.
+// Запись устаревает, если изменился список документов любого слова запроса или версия данных,
+// по которым вычисляется IDF
+class QueryCache {
+public:
+    explicit QueryCache(size_t memory_limit);
+
+    std::optional<std::vector<Document>> Find(const std::string& key, uint64_t idf_version);
+    void Insert(std::string key, uint64_t idf_version, std::vector<Document> documents);
+    // Удаляет записи запросов, содержащих слово
+    void Invalidate(std::string_view word);
+    void Clear();
+
+    QueryCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t idf_version;
+        std::vector<Document> documents;
+        // ссылаются на key
+        std::vector<std::string_view> words;
+        size_t memory_usage;
+    };
+    using EntryIterator = std::list<Entry>::iterator;
+
+    const size_t memory_limit_;
+    mutable std::mutex mutex_;
+    // в начале - недавно использованные записи
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, EntryIterator> entries_by_key_;
+    std::unordered_multimap<std::string_view, EntryIterator> entries_by_word_;
+    QueryCacheStats stats_;
+
+    void Erase(EntryIterator entry);
+};
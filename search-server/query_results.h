@@ -0,0 +1,49 @@
+#pragma once
+#include "document.h"
+#include "paginator.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Результаты пакета запросов в одном непрерывном буфере.
+// Документы запроса i занимают [offsets[i], offsets[i + 1])
+class QueryResults {
+public:
+    using Iterator = std::vector<Document>::const_iterator;
+
+    QueryResults()
+        : offsets_(1, 0) {
+    }
+
+    QueryResults(std::vector<Document> documents, std::vector<size_t> offsets)
+        : documents_(std::move(documents))
+        , offsets_(std::move(offsets)) {
+    }
+
+    size_t GetQueryCount() const {
+        return offsets_.size() - 1;
+    }
+
+    IteratorRange<Iterator> operator[](size_t query_index) const {
+        return IteratorRange<Iterator>(documents_.begin() + offsets_[query_index],
+            documents_.begin() + offsets_[query_index + 1]);
+    }
+
+    // Обход документов всех запросов подряд
+    Iterator begin() const {
+        return documents_.begin();
+    }
+
+    Iterator end() const {
+        return documents_.end();
+    }
+
+    size_t size() const {
+        return documents_.size();
+    }
+
+private:
+    std::vector<Document> documents_;
+    std::vector<size_t> offsets_;
+};
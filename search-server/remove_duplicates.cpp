@@ -1,23 +1,218 @@
 #include "remove_duplicates.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <execution>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
 using namespace std;
 
-void RemoveDuplicates(SearchServer& search_server) {
-    set<int> documents_for_delete; //  
-    set<set<string_view>> original_documents;
-    for (const int document_id : search_server) {
-        set<string_view> words_document;
-        for (const auto& [word, freq] : search_server.GetWordFrequencies(document_id)) {
-            words_document.insert(word);
+namespace {
+    uint64_t MixHash(uint64_t value) {
+        //   splitmix64
+        value += 0x9E3779B97F4A7C15;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+        return value ^ (value >> 31);
+    }
+
+    // 128-   :       
+    using Fingerprint = pair<uint64_t, uint64_t>;
+
+    Fingerprint ComputeFingerprint(const vector<TermId>& document_terms) {
+        Fingerprint fingerprint{ document_terms.size(), 0 };
+        for (const TermId term : document_terms) {
+            fingerprint.first += MixHash(term);
+            fingerprint.second += MixHash(term ^ 0x5BD1E995'00000000);
+        }
+        return fingerprint;
+    }
+
+    //     
+    double ComputeSimilarity(const vector<TermId>& lhs, const vector<TermId>& rhs) {
+        if (lhs.empty() && rhs.empty()) {
+            return 1.0;
+        }
+        size_t common_count = 0;
+        for (auto left = lhs.begin(), right = rhs.begin(); left != lhs.end() && right != rhs.end();) {
+            if (*left < *right) {
+                ++left;
+            } else if (*right < *left) {
+                ++right;
+            } else {
+                ++common_count;
+                ++left;
+                ++right;
+            }
+        }
+        return static_cast<double>(common_count) / (lhs.size() + rhs.size() - common_count);
+    }
+
+    constexpr size_t MINHASH_COUNT = 128;
+
+    //  LSH  rows_per_band  :      .
+    //    ,             
+    size_t ComputeRowsPerBand(double similarity_threshold) {
+        size_t rows_per_band = 1;
+        for (size_t rows = 2; rows <= MINHASH_COUNT / 4; rows *= 2) {
+            const double band_count = static_cast<double>(MINHASH_COUNT / rows);
+            if (1.0 - pow(1.0 - pow(similarity_threshold, rows), band_count) >= 0.95) {
+                rows_per_band = rows;
+            }
+        }
+        return rows_per_band;
+    }
+
+    //      .    id
+    void MarkNearDuplicates(const vector<vector<TermId>>& documents_terms, double similarity_threshold,
+        vector<bool>& is_duplicate) {
+        vector<size_t> candidates;
+        for (size_t i = 0; i < documents_terms.size(); ++i) {
+            if (!is_duplicate[i] && !documents_terms[i].empty()) {
+                candidates.push_back(i);
+            }
+        }
+        vector<array<uint64_t, MINHASH_COUNT>> signatures(candidates.size());
+        transform(execution::par, candidates.begin(), candidates.end(), signatures.begin(), [&](size_t index) {
+            array<uint64_t, MINHASH_COUNT> signature;
+            signature.fill(numeric_limits<uint64_t>::max());
+            for (const TermId term : documents_terms[index]) {
+                const uint64_t term_hash = MixHash(term);
+                for (size_t k = 0; k < MINHASH_COUNT; ++k) {
+                    signature[k] = min(signature[k], MixHash(term_hash + k));
+                }
+            }
+            return signature;
+        });
+
+        const size_t rows_per_band = ComputeRowsPerBand(similarity_threshold);
+        const size_t band_count = MINHASH_COUNT / rows_per_band;
+        // ( , ,  ):      
+        vector<tuple<uint64_t, uint32_t, uint32_t>> bands;
+        bands.reserve(candidates.size() * band_count);
+        for (uint32_t position = 0; position < candidates.size(); ++position) {
+            for (uint32_t band = 0; band < band_count; ++band) {
+                uint64_t band_hash = band;
+                for (size_t row = band * rows_per_band; row < (band + 1) * rows_per_band; ++row) {
+                    band_hash = MixHash(band_hash ^ signatures[position][row]);
+                }
+                bands.emplace_back(band_hash, band, position);
+            }
         }
-        if (original_documents.count(words_document)) {
-            documents_for_delete.insert(document_id);
-        } else {
-            original_documents.insert(words_document);
+        sort(execution::par, bands.begin(), bands.end());
+
+        vector<pair<uint32_t, uint32_t>> pairs;
+        for (size_t begin = 0; begin < bands.size();) {
+            size_t end = begin + 1;
+            while (end < bands.size() && get<0>(bands[end]) == get<0>(bands[begin]) && get<1>(bands[end]) == get<1>(bands[begin])) {
+                ++end;
+            }
+            for (size_t later = begin + 1; later < end; ++later) {
+                for (size_t earlier = begin; earlier < later; ++earlier) {
+                    pairs.emplace_back(get<2>(bands[later]), get<2>(bands[earlier]));
+                }
+            }
+            begin = end;
+        }
+        sort(execution::par, pairs.begin(), pairs.end());
+        pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+        //     ,      id,
+        //   ,       
+        vector<char> is_similar(pairs.size());
+        transform(execution::par, pairs.begin(), pairs.end(), is_similar.begin(), [&](const pair<uint32_t, uint32_t>& candidate_pair) {
+            return ComputeSimilarity(documents_terms[candidates[candidate_pair.first]],
+                documents_terms[candidates[candidate_pair.second]]) >= similarity_threshold;
+        });
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            const size_t later = candidates[pairs[i].first];
+            const size_t earlier = candidates[pairs[i].second];
+            if (is_similar[i] && !is_duplicate[earlier]) {
+                is_duplicate[later] = true;
+            }
         }
     }
+
+    set<int> FindDuplicates(SearchServer& search_server, double similarity_threshold) {
+        if (!(similarity_threshold > 0.0 && similarity_threshold <= 1.0)) {
+            throw invalid_argument("The similarity threshold must be in (0, 1]."s);
+        }
+        const vector<int> document_ids(search_server.begin(), search_server.end());
+        const size_t document_count = document_ids.size();
+        vector<vector<TermId>> documents_terms(document_count);
+        transform(execution::par, document_ids.begin(), document_ids.end(), documents_terms.begin(),
+            [&search_server](int document_id) {
+                return search_server.GetDocumentTerms(document_id);
+            });
+        vector<Fingerprint> fingerprints(document_count);
+        transform(execution::par, documents_terms.begin(), documents_terms.end(), fingerprints.begin(), ComputeFingerprint);
+
+        //         id.  
+        //          
+        vector<size_t> order(document_count);
+        iota(order.begin(), order.end(), 0);
+        sort(execution::par, order.begin(), order.end(), [&fingerprints](size_t lhs, size_t rhs) {
+            return tie(fingerprints[lhs], lhs) < tie(fingerprints[rhs], rhs);
+        });
+        vector<bool> is_duplicate(document_count, false);
+        vector<size_t> originals;
+        for (size_t begin = 0; begin < document_count;) {
+            size_t end = begin + 1;
+            while (end < document_count && fingerprints[order[end]] == fingerprints[order[begin]]) {
+                ++end;
+            }
+            originals.clear();
+            for (size_t i = begin; i < end; ++i) {
+                const vector<TermId>& document_terms = documents_terms[order[i]];
+                if (any_of(originals.begin(), originals.end(), [&](size_t original) {
+                    return documents_terms[original] == document_terms;
+                })) {
+                    is_duplicate[order[i]] = true;
+                } else {
+                    originals.push_back(order[i]);
+                }
+            }
+            begin = end;
+        }
+
+        if (similarity_threshold < 1.0) {
+            MarkNearDuplicates(documents_terms, similarity_threshold, is_duplicate);
+        }
+        set<int> documents_for_delete; //  
+        for (size_t i = 0; i < document_count; ++i) {
+            if (is_duplicate[i]) {
+                documents_for_delete.insert(documents_for_delete.end(), document_ids[i]);
+            }
+        }
+        return documents_for_delete;
+    }
+} // namespace
+
+void RemoveDuplicates(SearchServer& search_server, double similarity_threshold) {
+    //      
+    const set<int> documents_for_delete = FindDuplicates(search_server, similarity_threshold);
     for (const int id : documents_for_delete) {
         cout << "Found duplicate document id "s << id << endl;
-        search_server.RemoveDocument(id);
+    }
+    search_server.RemoveDocuments(execution::par, vector<int>(documents_for_delete.begin(), documents_for_delete.end()));
+}
+
+void RemoveDuplicates(ConcurrentSearchServer& search_server, double similarity_threshold) {
+    optional<set<int>> documents_for_delete;
+    search_server.Write([&documents_for_delete, similarity_threshold](SearchServer& server) {
+        //     ,      
+        if (!documents_for_delete) {
+            documents_for_delete = FindDuplicates(server, similarity_threshold);
+        }
+        server.RemoveDocuments(execution::par, vector<int>(documents_for_delete->begin(), documents_for_delete->end()));
+    });
+    for (const int id : *documents_for_delete) {
+        cout << "Found duplicate document id "s << id << endl;
     }
 }
@@ -1,4 +1,11 @@
 #pragma once
 #include "search_server.h"
+#include "concurrent_search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+// Удаляет документы, множество слов которых совпадает с множеством слов документа с меньшим id.
+// При similarity_threshold < 1 дубликатом считается и документ, у которого коэффициент Жаккара
+// множеств слов с оставшимся документом с меньшим id не меньше порога. Такие пары отбираются
+// по MinHash-подписям (LSH), поэтому небольшая часть почти совпадающих документов может быть пропущена
+void RemoveDuplicates(SearchServer& search_server, double similarity_threshold = 1.0);
+// Поиск дубликатов не останавливает чтение: он выполняется на скрытом экземпляре сервера
+void RemoveDuplicates(ConcurrentSearchServer& search_server, double similarity_threshold = 1.0);
\ No newline at end of file
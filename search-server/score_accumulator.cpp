@@ -0,0 +1,25 @@
+#include "score_accumulator.h"
+
+using namespace std;
+
+void ScoreAccumulator::Prepare(size_t ordinal_count, size_t stripe_count) {
+    // после исключения посреди запроса в полосах могли остаться незачищенные документы
+    for (vector<int>& touched : touched_) {
+        Clear(touched);
+    }
+    if (relevances_.size() < ordinal_count) {
+        relevances_.resize(ordinal_count, 0.0);
+        states_.resize(ordinal_count, State::EMPTY);
+    }
+    if (touched_.size() < stripe_count) {
+        touched_.resize(stripe_count);
+    }
+}
+
+void ScoreAccumulator::Clear(vector<int>& touched) {
+    for (const int ordinal : touched) {
+        relevances_[ordinal] = 0.0;
+        states_[ordinal] = State::EMPTY;
+    }
+    touched.clear();
+}
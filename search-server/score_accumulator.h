@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Накопитель релевантности, адресуемый порядковым номером документа.
+// Диапазон номеров делится на непересекающиеся полосы, у каждой полосы свой список затронутых
+// документов, поэтому полосы заполняются параллельно без блокировок.
+// Массивы не освобождаются между запросами: очищаются только затронутые элементы
+class ScoreAccumulator {
+public:
+    // Готовит накопитель к запросу по ordinal_count документам, разбитому на stripe_count полос
+    void Prepare(size_t ordinal_count, size_t stripe_count);
+
+    void Add(size_t stripe, int ordinal, double relevance) {
+        if (states_[ordinal] == State::EMPTY) {
+            states_[ordinal] = State::SCORED;
+            touched_[stripe].push_back(ordinal);
+        }
+        relevances_[ordinal] += relevance;
+    }
+
+    // Документ исключается из выдачи независимо от порядка вызовов Add и Exclude
+    void Exclude(size_t stripe, int ordinal) {
+        if (states_[ordinal] == State::EMPTY) {
+            touched_[stripe].push_back(ordinal);
+        }
+        states_[ordinal] = State::EXCLUDED;
+    }
+
+    // Передаёт function(ordinal, relevance) неисключённые документы полосы и очищает полосу
+    template <typename Function>
+    void Drain(size_t stripe, Function function);
+
+private:
+    enum class State : uint8_t {
+        EMPTY,
+        SCORED,
+        EXCLUDED,
+    };
+
+    std::vector<double> relevances_;
+    std::vector<State> states_;
+    std::vector<std::vector<int>> touched_;
+
+    void Clear(std::vector<int>& touched);
+};
+
+template <typename Function>
+void ScoreAccumulator::Drain(size_t stripe, Function function) {
+    for (const int ordinal : touched_[stripe]) {
+        if (states_[ordinal] == State::SCORED) {
+            function(ordinal, relevances_[ordinal]);
+        }
+    }
+    Clear(touched_[stripe]);
+}
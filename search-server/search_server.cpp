@@ -1,178 +1,950 @@
 #include "search_server.h"
+#include "snapshot.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 using namespace std;
 
-SearchServer::SearchServer(const string& stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text)) { //      string
+SearchServer::SearchServer(const string& stop_words_text, PostingListFormat posting_list_format)
+    : SearchServer(SplitIntoWords(stop_words_text), posting_list_format) { //      string
 }
 
-SearchServer::SearchServer(const string_view stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text)) {
+SearchServer::SearchServer(const string_view stop_words_text, PostingListFormat posting_list_format)
+    : SearchServer(SplitIntoWords(stop_words_text), posting_list_format) {
 }
 
 void SearchServer::AddDocument(int document_id, const string_view document, DocumentStatus status,
     const vector<int>& ratings) {
     //LOG_DURATION_STREAM("ADD"s, cerr);
-    if (documents_.count(document_id) > 0) {
-        throw invalid_argument("A document with this ID already exists."s);
-    } else if (document_id < 0) {
-        throw invalid_argument("A document cannot have a negative ID."s);
-    } else if (!IsValidWord(document)) {
+    CheckNewDocumentId(document_id);
+    //      
+    thread_local vector<string_view> words;
+    thread_local vector<TermId> document_terms;
+    if (!SplitIntoWords(document, words)) {
         throw invalid_argument("The content of the document contains invalid characters."s);
     }
-    const vector<string_view> words = SplitIntoWordsNoStop(document);
-    const double inv_word_count = 1.0 / words.size();
+    InstallMerges(false);
+    // -         
+    document_terms.clear();
     for (const string_view word : words) {
-        word_frequencies_in_document_[document_id][string(word)] += inv_word_count;
-        word_to_document_freqs_[(word_frequencies_in_document_[document_id].find(word)->first)][document_id] += inv_word_count;
+        const TermId term = terms_.Intern(word);
+        if (!IsStopTerm(term)) {
+            document_terms.push_back(term);
+        }
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-    order_addition_document_.insert(document_id);
+    const uint32_t word_count = static_cast<uint32_t>(document_terms.size());
+    const int ordinal = static_cast<int>(document_ids_by_ordinal_.size());
+    sort(document_terms.begin(), document_terms.end());
+    word_to_document_freqs_.resize(terms_.GetTermCount(), PostingList(posting_list_format_));
+    document_freqs_.resize(terms_.GetTermCount(), 0);
+    inverse_document_freqs_.resize(terms_.GetTermCount());
+    ++document_count_version_;
+    auto& word_frequencies = word_frequencies_in_document_.emplace_back();
+    for (auto term = document_terms.begin(); term != document_terms.end();) {
+        const auto term_end = upper_bound(term, document_terms.end(), *term);
+        const uint32_t term_count = static_cast<uint32_t>(term_end - term);
+        word_frequencies.push_back({ *term, PostingList::ComputeTermFreq(term_count, word_count) });
+        PostingList& postings = word_to_document_freqs_[*term];
+        if (postings.IsEmpty()) {
+            mutable_terms_.push_back(*term);
+        }
+        postings.Add(ordinal, term_count, word_count);
+        ++document_freqs_[*term];
+        term = term_end;
+    }
+    AddDocumentData(document_id, status, ComputeAverageRating(ratings));
+    InvalidateQueryCache(document_id);
+    if (document_ids_by_ordinal_.size() - mutable_begin_ordinal_ >= segment_document_count_) {
+        SealMutableSegment();
+    }
+}
+
+AddDocumentsError::AddDocumentsError(vector<Failure> failures)
+    : invalid_argument(to_string(failures.size()) + " documents were not added, the first error: "s
+        + (failures.empty() ? ""s : failures.front().message))
+    , failures_(move(failures)) {
 }
 
-vector<Document> SearchServer::FindTopDocuments(const string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
+const vector<AddDocumentsError::Failure>& AddDocumentsError::GetFailures() const {
+    return failures_;
+}
+
+void SearchServer::AddDocumentBatch(execution::sequenced_policy, const vector<const DocumentToAdd*>& documents) {
+    vector<AddDocumentsError::Failure> failures;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentToAdd& document = *documents[i];
+        try {
+            AddDocument(document.id, document.text, document.status, document.ratings);
+        } catch (const invalid_argument& error) {
+            failures.push_back({ i, document.id, error.what() });
+        }
+    }
+    if (!failures.empty()) {
+        throw AddDocumentsError(move(failures));
+    }
+}
+
+void SearchServer::AddDocumentBatch(execution::parallel_policy, const vector<const DocumentToAdd*>& documents) {
+    vector<string> errors(documents.size());
+    transform(execution::par, documents.begin(), documents.end(), errors.begin(), [this](const DocumentToAdd* document) {
+        try {
+            CheckNewDocument(document->id, document->text);
+        } catch (const invalid_argument& error) {
+            return string(error.what());
+        }
+        return string();
+    });
+    vector<AddDocumentsError::Failure> failures;
+    vector<const DocumentToAdd*> accepted_documents;
+    set<int> batch_ids;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        if (errors[i].empty() && !batch_ids.insert(documents[i]->id).second) {
+            errors[i] = "A document with this ID already exists."s;
+        }
+        if (errors[i].empty()) {
+            accepted_documents.push_back(documents[i]);
+        } else {
+            failures.push_back({ i, documents[i]->id, move(errors[i]) });
+        }
+    }
+    InstallMerges(false);
+
+    //  -     ,       .
+    //    ,      
+    struct Segment {
+        size_t begin;
+        size_t end;
+        vector<string_view> words;
+        vector<uint32_t> word_counts;
+        //    :     
+        vector<vector<pair<int, uint32_t>>> postings;
+        //    ->   
+        vector<TermId> terms;
+    };
+    const size_t accepted_count = accepted_documents.size();
+    const int first_ordinal = static_cast<int>(document_ids_by_ordinal_.size());
+    constexpr size_t MIN_SEGMENT_SIZE = 256;
+    const size_t segment_count = clamp<size_t>(accepted_count / MIN_SEGMENT_SIZE, 1,
+        max(1u, thread::hardware_concurrency()) * 4);
+    vector<Segment> segments(segment_count);
+    for (size_t i = 0; i < segment_count; ++i) {
+        segments[i].begin = accepted_count * i / segment_count;
+        segments[i].end = accepted_count * (i + 1) / segment_count;
+    }
+    word_frequencies_in_document_.resize(first_ordinal + accepted_count);
+    for_each(execution::par, segments.begin(), segments.end(), [&](Segment& segment) {
+        unordered_map<string_view, uint32_t> segment_terms;
+        vector<uint32_t> document_terms;
+        vector<string_view> words;
+        for (size_t i = segment.begin; i < segment.end; ++i) {
+            SplitIntoWordsNoStop(accepted_documents[i]->text, words);
+            document_terms.clear();
+            for (const string_view word : words) {
+                // find  emplace: emplace       
+                auto term = segment_terms.find(word);
+                if (term == segment_terms.end()) {
+                    term = segment_terms.emplace(word, static_cast<uint32_t>(segment.words.size())).first;
+                    segment.words.push_back(word);
+                    segment.postings.emplace_back();
+                }
+                document_terms.push_back(term->second);
+            }
+            sort(document_terms.begin(), document_terms.end());
+            const int ordinal = first_ordinal + static_cast<int>(i);
+            const uint32_t word_count = static_cast<uint32_t>(words.size());
+            //       ,     
+            auto& word_frequencies = word_frequencies_in_document_[ordinal];
+            for (auto term = document_terms.begin(); term != document_terms.end();) {
+                const auto term_end = upper_bound(term, document_terms.end(), *term);
+                const uint32_t term_count = static_cast<uint32_t>(term_end - term);
+                word_frequencies.push_back({ *term, PostingList::ComputeTermFreq(term_count, word_count) });
+                segment.postings[*term].push_back({ ordinal, term_count });
+                term = term_end;
+            }
+            segment.word_counts.push_back(word_count);
+        }
     });
+
+    // :       ,     ,
+    //       
+    vector<tuple<TermId, uint32_t, uint32_t>> segment_postings;
+    for (uint32_t i = 0; i < segment_count; ++i) {
+        Segment& segment = segments[i];
+        segment.terms.reserve(segment.words.size());
+        for (uint32_t term = 0; term < segment.words.size(); ++term) {
+            segment.terms.push_back(terms_.Intern(segment.words[term]));
+            segment_postings.emplace_back(segment.terms.back(), i, term);
+        }
+    }
+    word_to_document_freqs_.resize(terms_.GetTermCount(), PostingList(posting_list_format_));
+    document_freqs_.resize(terms_.GetTermCount(), 0);
+    inverse_document_freqs_.resize(terms_.GetTermCount());
+    ++document_count_version_;
+
+    //         ,
+    //     .     
+    sort(execution::par, segment_postings.begin(), segment_postings.end());
+    vector<size_t> term_starts;
+    for (size_t i = 0; i < segment_postings.size(); ++i) {
+        if (i == 0 || get<0>(segment_postings[i]) != get<0>(segment_postings[i - 1])) {
+            term_starts.push_back(i);
+            mutable_terms_.push_back(get<0>(segment_postings[i]));
+        }
+    }
+    for_each(execution::par, segments.begin(), segments.end(), [&](const Segment& segment) {
+        for (size_t i = segment.begin; i < segment.end; ++i) {
+            auto& word_frequencies = word_frequencies_in_document_[first_ordinal + i];
+            for (auto& [term, freq] : word_frequencies) {
+                term = segment.terms[term];
+            }
+            sort(word_frequencies.begin(), word_frequencies.end());
+        }
+    });
+    for_each(execution::par, term_starts.begin(), term_starts.end(), [&](size_t start) {
+        const TermId term = get<0>(segment_postings[start]);
+        PostingList& postings = word_to_document_freqs_[term];
+        for (size_t i = start; i < segment_postings.size() && get<0>(segment_postings[i]) == term; ++i) {
+            const auto& [global_term, segment_index, segment_term] = segment_postings[i];
+            const Segment& segment = segments[segment_index];
+            for (const auto& [ordinal, term_count] : segment.postings[segment_term]) {
+                postings.Add(ordinal, term_count, segment.word_counts[ordinal - first_ordinal - segment.begin]);
+            }
+            document_freqs_[term] += static_cast<uint32_t>(segment.postings[segment_term].size());
+        }
+    });
+
+    for (size_t i = 0; i < accepted_count; ++i) {
+        const DocumentToAdd& document = *accepted_documents[i];
+        AddDocumentData(document.id, document.status, ComputeAverageRating(document.ratings));
+    }
+    if (query_cache_ && accepted_count > 0) {
+        query_cache_->Clear();
+    }
+    if (document_ids_by_ordinal_.size() - mutable_begin_ordinal_ >= segment_document_count_) {
+        SealMutableSegment();
+    }
+    if (!failures.empty()) {
+        throw AddDocumentsError(move(failures));
+    }
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
+    return FindTopDocuments(execution::seq, raw_query, status, max_result_count);
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view raw_query) const {
     return FindTopDocuments(execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
+const vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const string_view raw_query,
+    DocumentStatus status, size_t max_result_count) const {
+    ParseQuery(raw_query, context.query_);
+    FindTopDocumentsByQuery(execution::seq, context, StatusPredicate{ status }, max_result_count);
+    return context.documents_;
+}
+
+void SearchServer::SetDynamicPruning(bool is_enabled) {
+    is_dynamic_pruning_enabled_ = is_enabled;
+}
+
+QueryResults SearchServer::FindTopDocumentsBatch(const vector<string>& raw_queries, DocumentStatus status,
+    size_t max_result_count) const {
+    const size_t query_count = raw_queries.size();
+    vector<Query> queries(query_count);
+    transform(execution::par, raw_queries.begin(), raw_queries.end(), queries.begin(), [this](const string& raw_query) {
+        return ParseQuery(raw_query);
+    });
+
+    //  :    IDF    
+    struct BatchWord {
+        TermId term;
+        //     
+        vector<const PostingList*> postings;
+        double inverse_document_freq;
+    };
+    unordered_map<string_view, BatchWord> batch_words;
+    for (const Query& query : queries) {
+        for (const auto* words : { &query.plus_words, &query.minus_words }) {
+            for (const string_view word : *words) {
+                if (batch_words.count(word) > 0) {
+                    continue;
+                }
+                BatchWord& batch_word = batch_words.emplace(word, BatchWord{ FindTerm(word), {}, 0.0 }).first->second;
+                if (batch_word.term != TermDictionary::NO_TERM) {
+                    ForEachSegmentPostings(batch_word.term, [&batch_word](const PostingList& postings) {
+                        batch_word.postings.push_back(&postings);
+                    });
+                    batch_word.inverse_document_freq = ComputeWordInverseDocumentFreq(batch_word.term);
+                }
+            }
+        }
+    }
+
+    //        ,      
+    //     ,       .        :
+    //               ,
+    //    ,    IDF
+    vector<TermId> heaviest_terms(query_count, TermDictionary::NO_TERM);
+    for (size_t i = 0; i < query_count; ++i) {
+        uint32_t max_document_count = 0;
+        for (const string_view word : queries[i].plus_words) {
+            const TermId term = batch_words.at(word).term;
+            if (term != TermDictionary::NO_TERM && document_freqs_[term] > max_document_count) {
+                max_document_count = document_freqs_[term];
+                heaviest_terms[i] = term;
+            }
+        }
+    }
+    vector<size_t> order(query_count);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&heaviest_terms](size_t lhs, size_t rhs) {
+        return heaviest_terms[lhs] < heaviest_terms[rhs];
+    });
+
+    //   i   [i * result_capacity, (i + 1) * result_capacity)  
+    const size_t result_capacity = min(max_result_count, ordinals_by_document_id_.size());
+    vector<Document> documents(query_count * result_capacity);
+    vector<size_t> offsets(query_count + 1, 0);
+    constexpr size_t QUERIES_PER_TASK = 64;
+    vector<size_t> tasks((query_count + QUERIES_PER_TASK - 1) / QUERIES_PER_TASK);
+    iota(tasks.begin(), tasks.end(), 0);
+    const int ordinal_count = static_cast<int>(document_ids_by_ordinal_.size());
+    for_each(execution::par, tasks.begin(), tasks.end(), [&](size_t task) {
+        thread_local PostingsQuery postings_query;
+        thread_local vector<Document> matched_documents;
+        ScoreAccumulator& accumulator = GetScoreAccumulator();
+        const size_t task_end = min(query_count, (task + 1) * QUERIES_PER_TASK);
+        for (size_t position = task * QUERIES_PER_TASK; position < task_end; ++position) {
+            const size_t query_index = order[position];
+            matched_documents.clear();
+            QueryContext& context = GetQueryContext();
+            context.query_ = queries[query_index];
+            if (!ResolveQueryTerms(context)) {
+                continue;
+            }
+            if (!context.query_.required_words.empty() || IsStatusScanCheaper(context, status)) {
+                //         
+                //     
+                FindAllDocuments(execution::seq, context, StatusPredicate{ status });
+                matched_documents.assign(context.documents_.begin(), context.documents_.end());
+                SelectTopDocuments(execution::seq, matched_documents, result_capacity, IsMoreRelevant);
+                copy(matched_documents.begin(), matched_documents.end(), documents.begin() + query_index * result_capacity);
+                offsets[query_index + 1] = matched_documents.size();
+                continue;
+            }
+            postings_query.plus_postings.clear();
+            postings_query.minus_postings.clear();
+            postings_query.removed_ordinals = &removed_ordinals_;
+            for (const string_view word : queries[query_index].plus_words) {
+                const BatchWord& batch_word = batch_words.at(word);
+                for (const PostingList* postings : batch_word.postings) {
+                    postings_query.plus_postings.push_back({ postings, batch_word.inverse_document_freq });
+                }
+            }
+            for (const string_view word : queries[query_index].minus_words) {
+                const BatchWord& batch_word = batch_words.at(word);
+                postings_query.minus_postings.insert(postings_query.minus_postings.end(),
+                    batch_word.postings.begin(), batch_word.postings.end());
+            }
+
+            accumulator.Prepare(ordinal_count, 1);
+            ScoreStripe(postings_query, accumulator, 0, 0, ordinal_count, [&](int ordinal, double relevance) {
+                if (document_statuses_by_ordinal_[ordinal] == status) {
+                    matched_documents.push_back({ document_ids_by_ordinal_[ordinal], relevance, document_ratings_by_ordinal_[ordinal] });
+                }
+            });
+            SelectTopDocuments(execution::seq, matched_documents, result_capacity, IsMoreRelevant);
+            copy(matched_documents.begin(), matched_documents.end(), documents.begin() + query_index * result_capacity);
+            offsets[query_index + 1] = matched_documents.size();
+        }
+    });
+
+    //  :       
+    for (size_t i = 0; i < query_count; ++i) {
+        const size_t count = offsets[i + 1];
+        offsets[i + 1] = offsets[i] + count;
+        const auto source = documents.begin() + i * result_capacity;
+        move(source, source + count, documents.begin() + offsets[i]);
+    }
+    documents.resize(offsets.back());
+    return QueryResults(move(documents), move(offsets));
+}
+
 int SearchServer::GetDocumentCount() const {
-    return static_cast<int>(documents_.size());
+    return static_cast<int>(ordinals_by_document_id_.size());
+}
+
+map<string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    map<string_view, double> word_frequencies;
+    const auto document = ordinals_by_document_id_.find(document_id);
+    if (document == ordinals_by_document_id_.end()) {
+        return word_frequencies;
+    }
+    for (const auto& [term, freq] : word_frequencies_in_document_[document->second]) {
+        word_frequencies.emplace(terms_.GetTerm(term), freq);
+    }
+    return word_frequencies;
+}
+
+vector<TermId> SearchServer::GetDocumentTerms(int document_id) const {
+    vector<TermId> document_terms;
+    const auto document = ordinals_by_document_id_.find(document_id);
+    if (document == ordinals_by_document_id_.end()) {
+        return document_terms;
+    }
+    const auto& word_frequencies = word_frequencies_in_document_[document->second];
+    document_terms.reserve(word_frequencies.size());
+    for (const auto& [term, freq] : word_frequencies) {
+        document_terms.push_back(term);
+    }
+    return document_terms;
+}
+
+vector<int>::const_iterator SearchServer::begin() {
+    SortDocumentIds();
+    return sorted_document_ids_.begin();
+}
+
+vector<int>::const_iterator SearchServer::end() {
+    SortDocumentIds();
+    return sorted_document_ids_.end();
+}
+
+void SearchServer::SetQueryCacheMemoryLimit(size_t memory_limit) {
+    if (memory_limit == 0) {
+        query_cache_.reset();
+    } else {
+        query_cache_ = make_unique<QueryCache>(memory_limit);
+    }
+}
+
+QueryCacheStats SearchServer::GetQueryCacheStats() const {
+    return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
+}
+
+size_t SearchServer::GetPostingsMemoryUsage() const {
+    size_t memory_usage = 0;
+    for (const auto& segment : sealed_segments_) {
+        memory_usage += segment->GetMemoryUsage();
+    }
+    for (const PostingList& postings : word_to_document_freqs_) {
+        memory_usage += postings.GetMemoryUsage();
+    }
+    return memory_usage;
+}
+
+void SearchServer::SetCorpusStatistics(shared_ptr<const CorpusStatistics> statistics) {
+    corpus_statistics_ = move(statistics);
+    //       ,   IDF  
+    for (CachedInverseDocumentFreq& cached : inverse_document_freqs_) {
+        cached.version.store(0, memory_order_relaxed);
+    }
+    //            
+    if (query_cache_) {
+        query_cache_->Clear();
+    }
 }
 
-const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if (!documents_.count(document_id)) {
-        static map<string_view, double> empty;
-        return empty;
+void SearchServer::SetSegmentDocumentCount(size_t document_count) {
+    if (document_count == 0) {
+        throw invalid_argument("A segment must hold at least one document."s);
     }
-    return (map<string_view, double>&) word_frequencies_in_document_.at(document_id);
+    segment_document_count_ = document_count;
+}
+
+void SearchServer::WaitForMerges() {
+    InstallMerges(true);
 }
 
-set<int>::const_iterator SearchServer::begin() {
-    return order_addition_document_.begin();
+size_t SearchServer::GetSealedSegmentCount() const {
+    return sealed_segments_.size();
 }
 
-set<int>::const_iterator SearchServer::end() {
-    return order_addition_document_.end();
+void SearchServer::SaveSnapshot(const string& path) const {
+    //       : ,   path, 
+    //    ,     
+    const string temporary_path = path + ".tmp"s;
+    {
+        ofstream output(temporary_path, ios::binary | ios::trunc);
+        if (!output) {
+            throw runtime_error("Cannot open file "s + temporary_path);
+        }
+        WriteSnapshot(output);
+        if (!output.flush()) {
+            output.close();
+            filesystem::remove(temporary_path);
+            throw runtime_error("Cannot write file "s + path);
+        }
+    }
+    error_code error;
+    filesystem::rename(temporary_path, path, error);
+    if (error) {
+        filesystem::remove(temporary_path, error);
+        throw runtime_error("Cannot write file "s + path);
+    }
+}
+
+void SearchServer::WriteSnapshot(ostream& output) const {
+    SnapshotWriter writer(output);
+    writer.Write(SNAPSHOT_MAGIC);
+    writer.Write(SNAPSHOT_VERSION);
+    writer.Write(SNAPSHOT_BYTE_ORDER_MARK);
+    writer.Write<uint32_t>(static_cast<uint32_t>(posting_list_format_));
+
+    writer.Write<uint64_t>(stop_words_.size());
+    for (const string& stop_word : stop_words_) {
+        writer.WriteString(stop_word);
+    }
+    writer.Write<uint64_t>(terms_.GetTermCount());
+    for (TermId term = 0; term < terms_.GetTermCount(); ++term) {
+        writer.WriteString(terms_.GetTerm(term));
+    }
+
+    //   -   ,    
+    const size_t ordinal_count = document_ids_by_ordinal_.size();
+    vector<int32_t> statuses(ordinal_count);
+    vector<uint8_t> removed_ordinals(ordinal_count);
+    for (size_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        statuses[ordinal] = static_cast<int32_t>(document_statuses_by_ordinal_[ordinal]);
+        removed_ordinals[ordinal] = removed_ordinals_[ordinal] ? 1 : 0;
+    }
+    writer.WriteArray(document_ids_by_ordinal_.data(), ordinal_count);
+    writer.WriteArray(document_ratings_by_ordinal_.data(), ordinal_count);
+    writer.WriteArray(statuses.data(), ordinal_count);
+    writer.WriteArray(removed_ordinals.data(), ordinal_count);
+
+    vector<TermId> document_terms;
+    vector<double> document_freqs;
+    for (const auto& word_frequencies : word_frequencies_in_document_) {
+        document_terms.clear();
+        document_freqs.clear();
+        for (const auto& [term, freq] : word_frequencies) {
+            document_terms.push_back(term);
+            document_freqs.push_back(freq);
+        }
+        writer.WriteArray(document_terms.data(), document_terms.size());
+        writer.WriteArray(document_freqs.data(), document_freqs.size());
+    }
+
+    //           
+    vector<const PostingList*> term_postings;
+    for (TermId term = 0; term < terms_.GetTermCount(); ++term) {
+        term_postings.clear();
+        ForEachSegmentPostings(term, [&term_postings](const PostingList& postings) {
+            term_postings.push_back(&postings);
+        });
+        if (term_postings.empty()) {
+            PostingList(posting_list_format_).Save(writer);
+        } else {
+            PostingList::Concatenate(term_postings, removed_ordinals_).Save(writer);
+        }
+    }
+}
+
+SearchServer SearchServer::LoadSnapshot(const string& path) {
+    auto snapshot = make_shared<const MappedFile>(path);
+    SnapshotReader reader(snapshot->GetData(), snapshot->GetSize());
+    const auto check = [](bool condition) {
+        if (!condition) {
+            throw invalid_argument("The snapshot is truncated or corrupted."s);
+        }
+    };
+    if (snapshot->GetSize() < sizeof(SNAPSHOT_MAGIC) || reader.Read<uint64_t>() != SNAPSHOT_MAGIC) {
+        throw invalid_argument("The file is not a search server snapshot."s);
+    }
+    if (reader.Read<uint32_t>() != SNAPSHOT_VERSION || reader.Read<uint32_t>() != SNAPSHOT_BYTE_ORDER_MARK) {
+        throw invalid_argument("The snapshot was written by an incompatible version."s);
+    }
+    const uint32_t posting_list_format = reader.Read<uint32_t>();
+    check(posting_list_format <= static_cast<uint32_t>(PostingListFormat::COMPRESSED));
+
+    vector<string> stop_words;
+    const uint64_t stop_word_count = reader.Read<uint64_t>();
+    for (uint64_t i = 0; i < stop_word_count; ++i) {
+        stop_words.emplace_back(reader.ReadString());
+    }
+    SearchServer search_server(stop_words, static_cast<PostingListFormat>(posting_list_format));
+
+    const uint64_t term_count = reader.Read<uint64_t>();
+    for (uint64_t term = 0; term < term_count; ++term) {
+        //         
+        check(search_server.terms_.Intern(reader.ReadString()) == term);
+    }
+
+    size_t ordinal_count = 0;
+    const int* document_ids = reader.ReadArray<int>(ordinal_count);
+    size_t array_size = 0;
+    const int* ratings = reader.ReadArray<int>(array_size);
+    check(array_size == ordinal_count);
+    const int32_t* statuses = reader.ReadArray<int32_t>(array_size);
+    check(array_size == ordinal_count);
+    const uint8_t* removed_ordinals = reader.ReadArray<uint8_t>(array_size);
+    check(array_size == ordinal_count);
+    search_server.document_ids_by_ordinal_.assign(document_ids, document_ids + ordinal_count);
+    search_server.document_ratings_by_ordinal_.assign(ratings, ratings + ordinal_count);
+    search_server.document_statuses_by_ordinal_.reserve(ordinal_count);
+    search_server.removed_ordinals_.reserve(ordinal_count);
+    for (size_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        check(statuses[ordinal] >= 0 && statuses[ordinal] <= static_cast<int32_t>(DocumentStatus::REMOVED));
+        search_server.document_statuses_by_ordinal_.push_back(static_cast<DocumentStatus>(statuses[ordinal]));
+        search_server.removed_ordinals_.push_back(removed_ordinals[ordinal] != 0);
+        if (removed_ordinals[ordinal] == 0) {
+            check(document_ids[ordinal] >= 0);
+            check(search_server.ordinals_by_document_id_.emplace(document_ids[ordinal], static_cast<int>(ordinal)).second);
+        }
+    }
+    search_server.are_document_ids_sorted_ = false;
+
+    search_server.word_frequencies_in_document_.resize(ordinal_count);
+    for (auto& word_frequencies : search_server.word_frequencies_in_document_) {
+        size_t entry_count = 0;
+        size_t freq_count = 0;
+        const TermId* document_terms = reader.ReadArray<TermId>(entry_count);
+        const double* document_freqs = reader.ReadArray<double>(freq_count);
+        check(entry_count == freq_count);
+        word_frequencies.reserve(entry_count);
+        for (size_t i = 0; i < entry_count; ++i) {
+            check(document_terms[i] < term_count);
+            word_frequencies.push_back({ document_terms[i], document_freqs[i] });
+        }
+    }
+
+    //       
+    vector<pair<TermId, PostingList>> postings;
+    search_server.document_freqs_.resize(term_count, 0);
+    search_server.inverse_document_freqs_.resize(term_count);
+    for (uint64_t term = 0; term < term_count; ++term) {
+        PostingList term_postings = PostingList::Load(reader, ordinal_count);
+        if (!term_postings.IsEmpty()) {
+            search_server.document_freqs_[term] = static_cast<uint32_t>(term_postings.GetDocumentCount());
+            postings.emplace_back(static_cast<TermId>(term), move(term_postings));
+        }
+    }
+    search_server.word_to_document_freqs_.resize(term_count, PostingList(search_server.posting_list_format_));
+    for (size_t ordinal = 0; ordinal < ordinal_count; ++ordinal) {
+        if (!search_server.removed_ordinals_[ordinal]) {
+            const size_t status = static_cast<size_t>(search_server.document_statuses_by_ordinal_[ordinal]);
+            search_server.status_partitions_[status].ordinals.push_back(static_cast<int>(ordinal));
+        }
+    }
+    search_server.mutable_begin_ordinal_ = static_cast<int>(ordinal_count);
+    if (ordinal_count > 0) {
+        search_server.PushSealedSegment(make_shared<const IndexSegment>(0, static_cast<int>(ordinal_count), move(postings)));
+    }
+    search_server.snapshot_ = move(snapshot);
+    return search_server;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
     SearchServer::RemoveDocument(execution::seq, document_id);
 }
 
-void SearchServer::RemoveDocument(execution::sequenced_policy, int document_id) {
-    if (!documents_.count(document_id)) {
-        throw invalid_argument("There is no document with the specified ID.");
+void SearchServer::RemoveDocument(execution::sequenced_policy policy, int document_id) {
+    RemoveDocuments(policy, { document_id });
+}
+
+void SearchServer::RemoveDocument(execution::parallel_policy policy, int document_id) {
+    RemoveDocuments(policy, { document_id });
+}
+
+void SearchServer::RemoveDocuments(execution::sequenced_policy, const vector<int>& document_ids) {
+    const vector<int> ordinals = CollectRemovedOrdinals(document_ids);
+    InstallMerges(false);
+    for (const int ordinal : ordinals) {
+        for (const auto& [term, freq] : word_frequencies_in_document_[ordinal]) {
+            RemoveTermOrdinal(term, ordinal);
+        }
     }
-    // log( ) *     , 
-    // ..     
-    for (const auto& [word, freq] : word_frequencies_in_document_.at(document_id)) {
-        // log(    )
-        word_to_document_freqs_[word].erase(document_id);
+    FinishRemoval(ordinals);
+}
+
+void SearchServer::RemoveDocuments(execution::parallel_policy, const vector<int>& document_ids) {
+    const vector<int> ordinals = CollectRemovedOrdinals(document_ids);
+    InstallMerges(false);
+    //            :    
+    //     ,         ,  
+    //  
+    vector<vector<pair<TermId, int>>> partitions(max(1u, thread::hardware_concurrency()));
+    for (const int ordinal : ordinals) {
+        for (const auto& [term, freq] : word_frequencies_in_document_[ordinal]) {
+            partitions[term % partitions.size()].emplace_back(term, ordinal);
+        }
     }
-    word_frequencies_in_document_.erase(document_id);
-    documents_.erase(document_id);
-    order_addition_document_.erase(document_id);
+    for_each(execution::par, partitions.begin(), partitions.end(), [this](const vector<pair<TermId, int>>& partition) {
+        for (const auto& [term, ordinal] : partition) {
+            RemoveTermOrdinal(term, ordinal);
+        }
+    });
+    FinishRemoval(ordinals);
 }
 
-void SearchServer::RemoveDocument(execution::parallel_policy, int document_id) {
-    if (!documents_.count(document_id)) {
-        throw invalid_argument("There is no document with the specified ID");
+vector<int> SearchServer::CollectRemovedOrdinals(const vector<int>& document_ids) const {
+    vector<int> ordinals;
+    ordinals.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        const auto document = ordinals_by_document_id_.find(document_id);
+        if (document == ordinals_by_document_id_.end()) {
+            throw invalid_argument("There is no document with the specified ID.");
+        }
+        ordinals.push_back(document->second);
     }
-    //   for
-    map<string, double, less<>>& frequency_word_in_each_document = word_frequencies_in_document_.at(document_id); //    
-    vector<const string*> words(frequency_word_in_each_document.size());
-    //       
-    transform(execution::par, frequency_word_in_each_document.begin(), frequency_word_in_each_document.end(),
-        words.begin(),
-        [](const pair<const string&, double>& ptr_to_word) {
-            return &ptr_to_word.first;
-        });
-    //   id     
-    for_each(execution::par, words.begin(), words.end(),
-        [this, document_id](const string* word) {
-            word_to_document_freqs_[*word].erase(document_id);
-        });
-    word_frequencies_in_document_.erase(document_id);
-    documents_.erase(document_id);
-    order_addition_document_.erase(document_id);
+    sort(ordinals.begin(), ordinals.end());
+    ordinals.erase(unique(ordinals.begin(), ordinals.end()), ordinals.end());
+    return ordinals;
+}
+
+void SearchServer::RemoveTermOrdinal(TermId term, int ordinal) {
+    PostingList& postings = word_to_document_freqs_[term];
+    //       ,       
+    if (ordinal >= mutable_begin_ordinal_) {
+        postings.Remove(ordinal);
+    }
+    //         
+    if (--document_freqs_[term] == 0) {
+        postings = PostingList(posting_list_format_);
+    }
+}
+
+void SearchServer::FinishRemoval(const vector<int>& ordinals) {
+    ++document_count_version_;
+    for (const int ordinal : ordinals) {
+        const int document_id = document_ids_by_ordinal_[ordinal];
+        InvalidateQueryCache(document_id);
+        word_frequencies_in_document_[ordinal] = {};
+        RemoveDocumentData(document_id);
+    }
+    DropRemovedSegments(ordinals);
+}
+
+void SearchServer::DropRemovedSegments(const vector<int>& ordinals) {
+    //     ,       
+    size_t segment = 0;
+    for (const int ordinal : ordinals) {
+        while (segment < sealed_segments_.size() && sealed_segments_[segment]->GetEndOrdinal() <= ordinal) {
+            ++segment;
+        }
+        if (segment == sealed_segments_.size()) {
+            break;
+        }
+        if (sealed_segments_[segment]->GetBeginOrdinal() <= ordinal) {
+            --sealed_live_counts_[segment];
+        }
+    }
+    // ,   ,   :     
+    const bool is_merging = pending_merge_.valid();
+    const size_t merge_begin = is_merging ? pending_merge_begin_ : sealed_segments_.size();
+    const size_t merge_end = is_merging ? pending_merge_begin_ + MERGE_FACTOR : sealed_segments_.size();
+    size_t kept_count = 0;
+    for (segment = 0; segment < sealed_segments_.size(); ++segment) {
+        if (sealed_live_counts_[segment] == 0 && (segment < merge_begin || segment >= merge_end)) {
+            if (is_merging && segment < merge_begin) {
+                --pending_merge_begin_;
+            }
+            continue;
+        }
+        sealed_segments_[kept_count] = move(sealed_segments_[segment]);
+        sealed_live_counts_[kept_count] = sealed_live_counts_[segment];
+        ++kept_count;
+    }
+    sealed_segments_.resize(kept_count);
+    sealed_live_counts_.resize(kept_count);
+}
+
+void SearchServer::PushSealedSegment(shared_ptr<const IndexSegment> segment) {
+    sealed_live_counts_.push_back(CountLiveOrdinals(segment->GetBeginOrdinal(), segment->GetEndOrdinal()));
+    sealed_segments_.push_back(move(segment));
+}
+
+size_t SearchServer::CountLiveOrdinals(int begin_ordinal, int end_ordinal) const {
+    return static_cast<size_t>(count(removed_ordinals_.begin() + begin_ordinal, removed_ordinals_.begin() + end_ordinal, false));
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const string_view raw_query, int document_id) const {
     return MatchDocument(execution::seq, raw_query, document_id);
 }
 
-tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(execution::sequenced_policy policy,
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(execution::sequenced_policy,
     const string_view raw_query, int document_id) const {
     //LOG_DURATION_STREAM("MatchDocument"s, cout);
-    if (document_id < 0 || word_frequencies_in_document_.count(document_id) == 0) {
-        throw out_of_range("There is no document with the specified ID");
-    }
-    const Query query = ParseQuery(raw_query);
-    if (any_of(policy, query.minus_words.begin(), query.minus_words.end(),
-        [this, document_id](const string_view minus_word) {
-            return word_to_document_freqs_.at(minus_word).count(document_id);
-        })) {
-        return { vector<string_view>(), documents_.at(document_id).status };
-    }
-    vector<string_view> matched_words(query.plus_words.size());
+    const int ordinal = GetDocumentOrdinal(document_id);
+    thread_local MatchQuery match_query;
+    ResolveMatchQuery(raw_query, match_query);
+    return MatchOrdinal(match_query, ordinal);
+}
 
-    vector<string_view>::iterator end_new_size = copy_if(policy, query.plus_words.begin(), query.plus_words.end(),
-        matched_words.begin(),
-        [this, document_id](const string_view plus_word) {
-            return word_to_document_freqs_.at(plus_word).count(document_id);
-        });
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(execution::parallel_policy,
+    const string_view raw_query, int document_id) const {
+    //           
+    return MatchDocument(execution::seq, raw_query, document_id);
+}
 
-    matched_words.resize(distance(matched_words.begin(), end_new_size));
-    set<string_view> unique_words(matched_words.begin(), matched_words.end());
+vector<SearchServer::words_and_status_document> SearchServer::MatchDocuments(execution::sequenced_policy,
+    const string_view raw_query, const vector<int>& document_ids) const {
+    vector<int> ordinals(document_ids.size());
+    transform(document_ids.begin(), document_ids.end(), ordinals.begin(), [this](int document_id) {
+        return GetDocumentOrdinal(document_id);
+    });
+    MatchQuery match_query;
+    ResolveMatchQuery(raw_query, match_query);
+    vector<words_and_status_document> result(ordinals.size());
+    transform(ordinals.begin(), ordinals.end(), result.begin(), [this, &match_query](int ordinal) {
+        return MatchOrdinal(match_query, ordinal);
+    });
+    return result;
+}
 
-    return { vector<string_view> { unique_words.begin(), unique_words.end() }, documents_.at(document_id).status };
+vector<SearchServer::words_and_status_document> SearchServer::MatchDocuments(execution::parallel_policy,
+    const string_view raw_query, const vector<int>& document_ids) const {
+    //       ,  id  
+    vector<int> ordinals(document_ids.size());
+    transform(document_ids.begin(), document_ids.end(), ordinals.begin(), [this](int document_id) {
+        return GetDocumentOrdinal(document_id);
+    });
+    MatchQuery match_query;
+    ResolveMatchQuery(raw_query, match_query);
+    vector<words_and_status_document> result(ordinals.size());
+    transform(execution::par, ordinals.begin(), ordinals.end(), result.begin(), [this, &match_query](int ordinal) {
+        return MatchOrdinal(match_query, ordinal);
+    });
+    return result;
 }
 
-tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(execution::parallel_policy policy,
-    const string_view raw_query, int document_id) const {
-    if (document_id < 0 || word_frequencies_in_document_.count(document_id) == 0) {
+void SearchServer::ResolveMatchQuery(const string_view raw_query, MatchQuery& match_query) const {
+    thread_local Query query;
+    ParseQuery(raw_query, query);
+    match_query.plus_terms.clear();
+    match_query.required_terms.clear();
+    match_query.minus_terms.clear();
+    match_query.is_unmatchable = false;
+    for (const string_view word : query.plus_words) {
+        const TermId term = FindTerm(word);
+        if (term != TermDictionary::NO_TERM) {
+            match_query.plus_terms.push_back({ word, term });
+        }
+    }
+    for (const string_view word : query.required_words) {
+        const TermId term = FindTerm(word);
+        if (term == TermDictionary::NO_TERM) {
+            match_query.is_unmatchable = true;
+        }
+        match_query.required_terms.push_back(term);
+    }
+    for (const string_view word : query.minus_words) {
+        const TermId term = FindTerm(word);
+        if (term != TermDictionary::NO_TERM) {
+            match_query.minus_terms.push_back(term);
+        }
+    }
+}
+
+int SearchServer::GetDocumentOrdinal(int document_id) const {
+    const auto document = ordinals_by_document_id_.find(document_id);
+    if (document == ordinals_by_document_id_.end()) {
         throw out_of_range("There is no document with the specified ID");
     }
-    Query query = ParseQuery(raw_query, false);
+    return document->second;
+}
 
-    if (any_of(policy, query.minus_words.begin(), query.minus_words.end(),
-        [this, document_id](const string_view minus_word) {
-            return word_to_document_freqs_.at(minus_word).count(document_id);
-        })) {
-        return { vector<string_view>(), documents_.at(document_id).status };
+SearchServer::words_and_status_document SearchServer::MatchOrdinal(const MatchQuery& match_query, int ordinal) const {
+    const DocumentStatus status = document_statuses_by_ordinal_[ordinal];
+    const auto& word_frequencies = word_frequencies_in_document_[ordinal];
+    const auto is_in_document = [&word_frequencies](TermId term) {
+        return FindTermFreq(word_frequencies, term) != nullptr;
+    };
+    //   -        
+    if (match_query.is_unmatchable
+        || any_of(match_query.minus_terms.begin(), match_query.minus_terms.end(), is_in_document)
+        || !all_of(match_query.required_terms.begin(), match_query.required_terms.end(), is_in_document)) {
+        return { vector<string_view>(), status };
+    }
+    vector<string_view> matched_words;
+    for (const auto& [word, term] : match_query.plus_terms) {
+        if (is_in_document(term)) {
+            matched_words.push_back(word);
+        }
     }
-    vector<string_view> matched_words(query.plus_words.size());
+    return { move(matched_words), status };
+}
 
-    vector<string_view>::iterator end_new_size = copy_if(policy, query.plus_words.begin(), query.plus_words.end(),
-        matched_words.begin(),
-        [this, document_id](const string_view plus_word) {
-            return word_to_document_freqs_.at(plus_word).count(document_id);
-        });
+void SearchServer::AddDocumentData(int document_id, DocumentStatus status, int rating) {
+    const int ordinal = static_cast<int>(document_ids_by_ordinal_.size());
+    ordinals_by_document_id_.emplace(document_id, ordinal);
+    if (are_document_ids_sorted_ && (sorted_document_ids_.empty() || sorted_document_ids_.back() < document_id)) {
+        sorted_document_ids_.push_back(document_id);
+    } else {
+        are_document_ids_sorted_ = false;
+    }
+    document_ids_by_ordinal_.push_back(document_id);
+    document_ratings_by_ordinal_.push_back(rating);
+    document_statuses_by_ordinal_.push_back(status);
+    status_partitions_[static_cast<size_t>(status)].ordinals.push_back(ordinal);
+    removed_ordinals_.push_back(false);
+}
 
-    matched_words.resize(distance(matched_words.begin(), end_new_size));
-    set<string_view> unique_words(matched_words.begin(), matched_words.end());
+void SearchServer::RemoveDocumentData(int document_id) {
+    const int ordinal = ordinals_by_document_id_.at(document_id);
+    removed_ordinals_[ordinal] = true;
+    StatusPartition& partition = status_partitions_[static_cast<size_t>(document_statuses_by_ordinal_[ordinal])];
+    if (++partition.removed_count * 2 > partition.ordinals.size()) {
+        partition.ordinals.erase(remove_if(partition.ordinals.begin(), partition.ordinals.end(), [this](int ordinal) {
+            return removed_ordinals_[ordinal];
+        }), partition.ordinals.end());
+        partition.removed_count = 0;
+    }
+    ordinals_by_document_id_.erase(document_id);
+    are_document_ids_sorted_ = false;
+}
 
-    return { vector<string_view> { unique_words.begin(), unique_words.end() }, documents_.at(document_id).status };
+void SearchServer::SortDocumentIds() {
+    if (are_document_ids_sorted_) {
+        return;
+    }
+    sorted_document_ids_.clear();
+    sorted_document_ids_.reserve(ordinals_by_document_id_.size());
+    for (size_t ordinal = 0; ordinal < document_ids_by_ordinal_.size(); ++ordinal) {
+        if (!removed_ordinals_[ordinal]) {
+            sorted_document_ids_.push_back(document_ids_by_ordinal_[ordinal]);
+        }
+    }
+    sort(sorted_document_ids_.begin(), sorted_document_ids_.end());
+    are_document_ids_sorted_ = true;
+}
+
+void SearchServer::CheckNewDocumentId(int document_id) const {
+    if (ordinals_by_document_id_.count(document_id) > 0) {
+        throw invalid_argument("A document with this ID already exists."s);
+    } else if (document_id < 0) {
+        throw invalid_argument("A document cannot have a negative ID."s);
+    }
+}
+
+void SearchServer::CheckNewDocument(int document_id, const string_view document) const {
+    CheckNewDocumentId(document_id);
+    if (!IsValidWord(document)) {
+        throw invalid_argument("The content of the document contains invalid characters."s);
+    }
 }
 
 bool SearchServer::IsStopWord(const string_view word) const {
-    return stop_words_.count(word) > 0;
+    return IsStopTerm(terms_.Find(word));
 }
 
-vector<string_view> SearchServer::SplitIntoWordsNoStop(const string_view text) const {
-    vector<string_view> words;
-    for (const string_view word : SplitIntoWords(text)) {
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+bool SearchServer::IsStopTerm(TermId term) const {
+    return term != TermDictionary::NO_TERM && term < stop_words_.size();
+}
+
+bool SearchServer::SplitIntoWordsNoStop(const string_view text, vector<string_view>& words) const {
+    const bool is_valid_text = SplitIntoWords(text, words);
+    if (!stop_words_.empty()) {
+        words.erase(remove_if(words.begin(), words.end(), [this](const string_view word) {
+            return IsStopWord(word);
+        }), words.end());
     }
-    return words;
+    return is_valid_text;
 }
 
 int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
@@ -185,6 +957,7 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
 
 SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
     bool is_minus = false;
+    bool is_required = false;
     // Word shouldn't be empty
     if (text.empty()) {
         throw invalid_argument("There is an empty word in the query.");
@@ -195,45 +968,323 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         }
         is_minus = true;
         text = text.substr(1);
+    } else if (text[0] == '+') {
+        if (text[1] == '+' || text[1] == '-') {
+            throw invalid_argument("The request contains two operator characters in a row.");
+        }
+        is_required = true;
+        text = text.substr(1);
     }
-    return { text, is_minus, IsStopWord(text) };
+    return { text, is_minus, is_required, IsStopWord(text) };
 }
 
-SearchServer::Query SearchServer::ParseQuery(const string_view text, bool sequenced_policy) const {
+SearchServer::Query SearchServer::ParseQuery(const string_view text) const {
     Query query;
-    for (const string_view word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
+    ParseQuery(text, query);
+    return query;
+}
+
+void SearchServer::ParseQuery(const string_view text, Query& query) const {
+    query.plus_words.clear();
+    query.required_words.clear();
+    query.minus_words.clear();
+    thread_local vector<string_view> words;
+    //    ,       
+    const bool is_valid_text = SplitIntoWords(text, words);
+    for (const string_view word : words) {
+        if (!is_valid_text && !IsValidWord(word)) {
             throw invalid_argument("Invalid search query.");
         }
         if (word == "-"s) {
             throw invalid_argument("There is no word after the \"-\" sign.");
         }
+        if (word == "+"s) {
+            throw invalid_argument("There is no word after the \"+\" sign.");
+        }
         QueryWord query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 query.minus_words.push_back(query_word.data);
             } else {
                 query.plus_words.push_back(query_word.data);
+                if (query_word.is_required) {
+                    query.required_words.push_back(query_word.data);
+                }
             }
         }
     }
-    if (sequenced_policy) {
-        sort(query.plus_words.begin(), query.plus_words.end());
-        query.plus_words.erase(unique(query.plus_words.begin(), query.plus_words.end()), query.plus_words.end());
+    sort(query.plus_words.begin(), query.plus_words.end());
+    query.plus_words.erase(unique(query.plus_words.begin(), query.plus_words.end()), query.plus_words.end());
+
+    sort(query.required_words.begin(), query.required_words.end());
+    query.required_words.erase(unique(query.required_words.begin(), query.required_words.end()), query.required_words.end());
+
+    sort(query.minus_words.begin(), query.minus_words.end());
+    query.minus_words.erase(unique(query.minus_words.begin(), query.minus_words.end()), query.minus_words.end());
+}
 
-        sort(query.minus_words.begin(), query.minus_words.end());
-        query.minus_words.erase(unique(query.minus_words.begin(), query.minus_words.end()), query.minus_words.end());
+TermId SearchServer::FindTerm(const string_view word) const {
+    const TermId term = terms_.Find(word);
+    if (term == TermDictionary::NO_TERM || document_freqs_[term] == 0) {
+        return TermDictionary::NO_TERM;
     }
-    return query;
+    return term;
+}
+
+const double* SearchServer::FindTermFreq(const vector<pair<TermId, double>>& word_frequencies, TermId term) {
+    //       
+    const auto it = lower_bound(word_frequencies.begin(), word_frequencies.end(), term,
+        [](const pair<TermId, double>& term_freq, TermId term) {
+            return term_freq.first < term;
+        });
+    return it != word_frequencies.end() && it->first == term ? &it->second : nullptr;
+}
+
+void SearchServer::ResolvePostings(const QueryContext& context, PostingsQuery& postings_query) const {
+    postings_query.plus_postings.clear();
+    postings_query.minus_postings.clear();
+    postings_query.removed_ordinals = &removed_ordinals_;
+    for (const QueryTerm& query_term : context.query_terms_) {
+        ForEachSegmentPostings(query_term.term, [&postings_query, &query_term](const PostingList& postings) {
+            postings_query.plus_postings.push_back({ &postings, query_term.inverse_document_freq });
+        });
+    }
+    for (const TermId term : context.minus_terms_) {
+        ForEachSegmentPostings(term, [&postings_query](const PostingList& postings) {
+            postings_query.minus_postings.push_back(&postings);
+        });
+    }
+}
+
+bool SearchServer::ResolveQueryTerms(QueryContext& context) const {
+    const Query& query = context.query_;
+    context.query_terms_.clear();
+    context.minus_terms_.clear();
+    for (const string_view word : query.plus_words) {
+        const bool is_required = find(query.required_words.begin(), query.required_words.end(), word) != query.required_words.end();
+        const TermId term = FindTerm(word);
+        if (term != TermDictionary::NO_TERM) {
+            context.query_terms_.push_back({ term, ComputeWordInverseDocumentFreq(term), is_required });
+        } else if (is_required) {
+            return false;
+        }
+    }
+    for (const string_view word : query.minus_words) {
+        const TermId term = FindTerm(word);
+        if (term != TermDictionary::NO_TERM) {
+            context.minus_terms_.push_back(term);
+        }
+    }
+    return true;
+}
+
+bool SearchServer::IsStatusScanCheaper(const QueryContext& context, DocumentStatus status) const {
+    //          
+    constexpr size_t LOOKUP_COST = 4;
+    size_t posting_count = 0;
+    size_t required_posting_count = numeric_limits<size_t>::max();
+    for (const QueryTerm& query_term : context.query_terms_) {
+        posting_count += document_freqs_[query_term.term];
+        if (query_term.is_required) {
+            required_posting_count = min<size_t>(required_posting_count, document_freqs_[query_term.term]);
+        }
+    }
+    //         
+    posting_count = min(posting_count, required_posting_count);
+    const size_t lookup_count = status_partitions_[static_cast<size_t>(status)].ordinals.size()
+        * (context.query_terms_.size() + context.minus_terms_.size());
+    return lookup_count * LOOKUP_COST < posting_count;
+}
+
+bool SearchServer::OpenTermCursors(const QueryContext& context, size_t segment, TermCursors& cursors) const {
+    const auto find_postings = [this, segment](TermId term) -> const PostingList* {
+        if (segment < sealed_segments_.size()) {
+            return sealed_segments_[segment]->FindPostings(term);
+        }
+        return word_to_document_freqs_[term].IsEmpty() ? nullptr : &word_to_document_freqs_[term];
+    };
+    cursors.required.clear();
+    cursors.optional.clear();
+    cursors.minus.clear();
+    cursors.word_scores.assign(context.query_terms_.size(), 0.0);
+    for (size_t i = 0; i < context.query_terms_.size(); ++i) {
+        const QueryTerm& query_term = context.query_terms_[i];
+        const PostingList* postings = find_postings(query_term.term);
+        if (postings == nullptr) {
+            if (query_term.is_required) {
+                return false;
+            }
+            continue;
+        }
+        (query_term.is_required ? cursors.required : cursors.optional).push_back({ PostingList::Cursor(*postings),
+            query_term.inverse_document_freq, postings->GetMaxTermFreq() * query_term.inverse_document_freq, i,
+            postings->GetDocumentCount() });
+    }
+    sort(cursors.required.begin(), cursors.required.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+        return lhs.document_count < rhs.document_count;
+    });
+    for (const TermId term : context.minus_terms_) {
+        if (const PostingList* postings = find_postings(term)) {
+            cursors.minus.emplace_back(*postings);
+        }
+    }
+    return true;
+}
+
+size_t SearchServer::QueryContext::GetEvaluatedPostingCount() const {
+    return evaluated_posting_count_;
+}
+
+ScoreAccumulator& SearchServer::GetScoreAccumulator() {
+    thread_local ScoreAccumulator accumulator;
+    return accumulator;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+SearchServer::QueryContext& SearchServer::GetQueryContext() {
+    thread_local QueryContext context;
+    return context;
+}
+
+size_t SearchServer::ComputeStripeCount(int ordinal_count) {
+    //     ,        
+    constexpr int MIN_STRIPE_SIZE = 1024;
+    //  ,  ,    
+    constexpr size_t STRIPES_PER_THREAD = 4;
+    const size_t max_stripe_count = max(1u, thread::hardware_concurrency()) * STRIPES_PER_THREAD;
+    return clamp<size_t>(static_cast<size_t>(ordinal_count / MIN_STRIPE_SIZE), 1, max_stripe_count);
+}
+
+string SearchServer::MakeQueryCacheKey(const Query& query, DocumentStatus status, size_t max_result_count) {
+    string key = to_string(static_cast<int>(status)) + ':' + to_string(max_result_count);
+    for (const string_view word : query.plus_words) {
+        key += ' ';
+        key += word;
+    }
+    for (const string_view word : query.required_words) {
+        key += " +"s;
+        key += word;
+    }
+    for (const string_view word : query.minus_words) {
+        key += " -"s;
+        key += word;
+    }
+    return key;
+}
+
+void SearchServer::InvalidateQueryCache(int document_id) {
+    if (!query_cache_) {
+        return;
+    }
+    for (const auto& [term, freq] : word_frequencies_in_document_[ordinals_by_document_id_.at(document_id)]) {
+        query_cache_->Invalidate(terms_.GetTerm(term));
+    }
+}
+
+SearchServer::CachedInverseDocumentFreq::CachedInverseDocumentFreq(const CachedInverseDocumentFreq& other)
+    : version(other.version.load())
+    , value(other.value.load()) {
+}
+
+uint64_t SearchServer::GetInverseDocumentFreqVersion() const {
+    return corpus_statistics_ ? corpus_statistics_->GetVersion() : document_count_version_;
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(TermId term) const {
+    CachedInverseDocumentFreq& cached = inverse_document_freqs_[term];
+    const uint64_t version = GetInverseDocumentFreqVersion();
+    //    ,      
+    if (cached.version.load(memory_order_acquire) == version) {
+        return cached.value.load(memory_order_relaxed);
+    }
+    const double inverse_document_freq = corpus_statistics_
+        ? log(corpus_statistics_->GetDocumentCount() * 1.0 / corpus_statistics_->GetDocumentFreq(terms_.GetTerm(term)))
+        : log(GetDocumentCount() * 1.0 / document_freqs_[term]);
+    cached.value.store(inverse_document_freq, memory_order_relaxed);
+    cached.version.store(version, memory_order_release);
+    return inverse_document_freq;
+}
+
+void SearchServer::SealMutableSegment() {
+    const int end_ordinal = static_cast<int>(document_ids_by_ordinal_.size());
+    sort(mutable_terms_.begin(), mutable_terms_.end());
+    mutable_terms_.erase(unique(mutable_terms_.begin(), mutable_terms_.end()), mutable_terms_.end());
+    vector<pair<TermId, PostingList>> postings;
+    postings.reserve(mutable_terms_.size());
+    for (const TermId term : mutable_terms_) {
+        PostingList term_postings = exchange(word_to_document_freqs_[term], PostingList(posting_list_format_));
+        if (!term_postings.IsEmpty()) {
+            term_postings.Compact();
+            postings.emplace_back(term, move(term_postings));
+        }
+    }
+    mutable_terms_.clear();
+    PushSealedSegment(make_shared<const IndexSegment>(mutable_begin_ordinal_, end_ordinal, move(postings)));
+    mutable_begin_ordinal_ = end_ordinal;
+    ScheduleMerge();
+}
+
+void SearchServer::ScheduleMerge() {
+    if (pending_merge_.valid()) {
+        return;
+    }
+    //     MERGE_FACTOR     
+    const auto get_level = [this](const shared_ptr<const IndexSegment>& segment) {
+        const size_t document_count = static_cast<size_t>(segment->GetEndOrdinal() - segment->GetBeginOrdinal());
+        int level = 0;
+        for (size_t size = segment_document_count_ * MERGE_FACTOR; document_count >= size; size *= MERGE_FACTOR) {
+            ++level;
+        }
+        return level;
+    };
+    for (size_t begin = 0; begin + MERGE_FACTOR <= sealed_segments_.size(); ++begin) {
+        const auto segments_begin = sealed_segments_.begin() + begin;
+        const int level = get_level(*segments_begin);
+        if (!all_of(segments_begin + 1, segments_begin + MERGE_FACTOR, [&](const auto& segment) {
+            return get_level(segment) == level;
+        })) {
+            continue;
+        }
+        //      : ,  ,   .
+        //  ,      
+        pending_merge_begin_ = begin;
+        pending_merge_ = async(launch::async,
+            [segments = vector<shared_ptr<const IndexSegment>>(segments_begin, segments_begin + MERGE_FACTOR),
+            removed_ordinals = removed_ordinals_, snapshot = snapshot_] {
+                vector<const IndexSegment*> segment_pointers;
+                for (const auto& segment : segments) {
+                    segment_pointers.push_back(segment.get());
+                }
+                return make_shared<const IndexSegment>(IndexSegment::Merge(segment_pointers, removed_ordinals));
+            });
+        return;
+    }
+}
+
+void SearchServer::InstallMerges(bool wait) {
+    while (pending_merge_.valid()
+        && (wait || pending_merge_.wait_for(chrono::seconds(0)) == future_status::ready)) {
+        shared_ptr<const IndexSegment> merged_segment = pending_merge_.get();
+        const auto segments_begin = sealed_segments_.begin() + pending_merge_begin_;
+        sealed_live_counts_[pending_merge_begin_] = CountLiveOrdinals(merged_segment->GetBeginOrdinal(), merged_segment->GetEndOrdinal());
+        *segments_begin = move(merged_segment);
+        sealed_segments_.erase(segments_begin + 1, segments_begin + MERGE_FACTOR);
+        sealed_live_counts_.erase(sealed_live_counts_.begin() + pending_merge_begin_ + 1,
+            sealed_live_counts_.begin() + pending_merge_begin_ + MERGE_FACTOR);
+        ScheduleMerge();
+    }
+}
+
+bool SearchServer::IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (abs(lhs.relevance - rhs.relevance) >= DELTA) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
 }
 
 bool SearchServer::IsValidWord(const string_view word) {
     //       
-    return none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-    });
+    return !HasControlCharacters(word);
 }
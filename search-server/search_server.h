@@ -1,14 +1,27 @@
 #pragma once
 #include "string_processing.h"
+#include "corpus_statistics.h"
 #include "document.h"
-#include "concurrent_map.h"
+#include "index_segment.h"
+#include "mapped_file.h"
+#include "posting_list.h"
+#include "query_cache.h"
+#include "query_results.h"
+#include "score_accumulator.h"
+#include "term_dictionary.h"
+#include "top_documents.h"
 
+#include <array>
+#include <atomic>
 #include <stdexcept>
 #include <string>
+#include <ostream>
 #include <string_view>
 #include <vector>
 #include <set>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <tuple>
 #include <numeric>
 #include <algorithm>
@@ -19,30 +32,83 @@
 #include <iterator>
 #include <type_traits>
 #include <future>
+#include <thread>
+#include <cstdint>
+#include <limits>
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double DELTA = 1e-6;
 
+//    :      
+class AddDocumentsError : public std::invalid_argument {
+public:
+    struct Failure {
+        //    
+        size_t position;
+        int document_id;
+        std::string message;
+    };
+
+    explicit AddDocumentsError(std::vector<Failure> failures);
+
+    const std::vector<Failure>& GetFailures() const;
+
+private:
+    std::vector<Failure> failures_;
+};
+
 class SearchServer {
 public:
+    class QueryContext;
+
+    // posting_list_format -     :   
+    //     ,     
     template <typename StringContainer>
-    SearchServer(const StringContainer& stop_words);
+    SearchServer(const StringContainer& stop_words, PostingListFormat posting_list_format = PostingListFormat::PLAIN);
     //      string
-    explicit SearchServer(const std::string& stop_words_text);
-    explicit SearchServer(const std::string_view stop_words_text);
+    explicit SearchServer(const std::string& stop_words_text, PostingListFormat posting_list_format = PostingListFormat::PLAIN);
+    explicit SearchServer(const std::string_view stop_words_text, PostingListFormat posting_list_format = PostingListFormat::PLAIN);
 
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    //    DocumentToAdd. ,    AddDocument
+    // (    id  ), ,     .
+    //   ,    AddDocumentsError   .
+    //                 
+    template <typename DocumentRange>
+    void AddDocuments(const DocumentRange& documents);
+    template <typename ExecutionPolicy, typename DocumentRange>
+    void AddDocuments(ExecutionPolicy policy, const DocumentRange& documents);
 
+    // max_result_count -    
     template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query) const;
     std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+    //    :       .  
+    //       .    
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const std::string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    //       (MaxScore    ):  
+    //      ,  ,    
+    //    ,     .     .
+    //   ;         
+    void SetDynamicPruning(bool is_enabled);
+
+    //    :        IDF    ,
+    //        .    
+    QueryResults FindTopDocumentsBatch(const std::vector<std::string>& raw_queries,
+        DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     using words_and_status_document = std::tuple<std::vector<std::string_view>, DocumentStatus>;
     //      
@@ -51,104 +117,445 @@ public:
         const std::string_view raw_query, int document_id) const;
     words_and_status_document MatchDocument(std::execution::parallel_policy,
         const std::string_view raw_query, int document_id) const;
+    //      :    ,  i -  document_ids[i].
+    //  out_of_range  ,      
+    std::vector<words_and_status_document> MatchDocuments(std::execution::sequenced_policy,
+        const std::string_view raw_query, const std::vector<int>& document_ids) const;
+    std::vector<words_and_status_document> MatchDocuments(std::execution::parallel_policy,
+        const std::string_view raw_query, const std::vector<int>& document_ids) const;
 
     int GetDocumentCount() const;
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    //        
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+    //      ,    id
+    std::vector<TermId> GetDocumentTerms(int document_id) const;
     void RemoveDocument(int document_id);
     void RemoveDocument(std::execution::sequenced_policy, int document_id);
     void RemoveDocument(std::execution::parallel_policy, int document_id);
+    //   :         ,
+    //  ,       , .
+    //  invalid_argument  ,      ;  id 
+    void RemoveDocuments(std::execution::sequenced_policy, const std::vector<int>& document_ids);
+    void RemoveDocuments(std::execution::parallel_policy, const std::vector<int>& document_ids);
+
+    // id   .       
+    std::vector<int>::const_iterator begin();
+    std::vector<int>::const_iterator end();
+
+    //   FindTopDocuments   . memory_limit -   , 0  .
+    //      
+    void SetQueryCacheMemoryLimit(size_t memory_limit);
+    QueryCacheStats GetQueryCacheStats() const;
+
+    // ,     
+    size_t GetPostingsMemoryUsage() const;
 
-    std::set<int>::const_iterator begin();
-    std::set<int>::const_iterator end();
+    //   ,    : IDF    .
+    //   ;      ,     .
+    // nullptr  IDF   
+    void SetCorpusStatistics(std::shared_ptr<const CorpusStatistics> statistics);
+
+    //  :   ,   (  DELTA) -   ,
+    //    id,       
+    static bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+    //       .  document_count , 
+    //    ,         .
+    //        
+    void SetSegmentDocumentCount(size_t document_count);
+    //       
+    void WaitForMerges();
+    size_t GetSealedSegmentCount() const;
+
+    //   -, ,       .
+    //      .  std::runtime_error   
+    void SaveSnapshot(const std::string& path) const;
+    //    ,        .
+    //  std::runtime_error,    ,  std::invalid_argument,
+    //       
+    static SearchServer LoadSnapshot(const std::string& path);
 
 private:
+    const std::set<std::string, std::less<>> stop_words_;
+    const PostingListFormat posting_list_format_;
+    //  ,    :     
+    std::shared_ptr<const MappedFile> snapshot_;
+    //   ,    . -    ,
+    //  - -       -
+    TermDictionary terms_;
+    //  :        mutable_begin_ordinal_,  -  
+    std::vector<PostingList> word_to_document_freqs_;
+    int mutable_begin_ordinal_ = 0;
+    // ,         ( )
+    std::vector<TermId> mutable_terms_;
+    //      
+    std::vector<std::shared_ptr<const IndexSegment>> sealed_segments_;
+    //       
+    std::vector<size_t> sealed_live_counts_;
+    size_t segment_document_count_ = 4096;
+    //  MERGE_FACTOR ,   pending_merge_begin_
+    std::future<std::shared_ptr<const IndexSegment>> pending_merge_;
+    size_t pending_merge_begin_ = 0;
+    //      ,  -  
+    std::vector<uint32_t> document_freqs_;
+    // IDF ,      version.     
+    //   ,  IDF       .
+    //        ,    
+    struct CachedInverseDocumentFreq {
+        std::atomic<uint64_t> version{ 0 };
+        std::atomic<double> value{ 0.0 };
 
-    std::set<int> order_addition_document_;
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
+        CachedInverseDocumentFreq() = default;
+        CachedInverseDocumentFreq(const CachedInverseDocumentFreq& other);
     };
-    const std::set<std::string, std::less<>> stop_words_;
-    //     
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    //     
-    std::map<int, std::map<std::string, double, std::less<>>> word_frequencies_in_document_;
+    mutable std::vector<CachedInverseDocumentFreq> inverse_document_freqs_;
+    uint64_t document_count_version_ = 1;
+    //       IDF   
+    std::shared_ptr<const CorpusStatistics> corpus_statistics_;
+    bool is_dynamic_pruning_enabled_ = false;
+    //      :        id
+    std::vector<int> document_ratings_by_ordinal_;
+    std::vector<DocumentStatus> document_statuses_by_ordinal_;
+    //      .    ,
+    //     
+    struct StatusPartition {
+        std::vector<int> ordinals;
+        size_t removed_count = 0;
+    };
+    static constexpr size_t STATUS_COUNT = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+    std::array<StatusPartition, STATUS_COUNT> status_partitions_;
+    //              
+    std::vector<bool> removed_ordinals_;
+    //       id
+    std::unordered_map<int, int> ordinals_by_document_id_;
+    // id      begin()  end().     id
+    //    ,           
+    std::vector<int> sorted_document_ids_;
+    bool are_document_ids_sorted_ = true;
+    //     ,     .
+    //     ,   id
+    std::vector<int> document_ids_by_ordinal_;
+    std::unique_ptr<QueryCache> query_cache_;
+    //        ,    .
+    //     
+    std::vector<std::vector<std::pair<TermId, double>>> word_frequencies_in_document_;
+
+    static constexpr uint64_t SNAPSHOT_MAGIC = 0x50414E5353525653; // "SVRSSNAP"
+    static constexpr uint32_t SNAPSHOT_VERSION = 4;
+    //         
+    static constexpr uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+    static constexpr size_t MERGE_FACTOR = 4;
+    //        
+    static constexpr double PRUNING_TOLERANCE = 1e-9;
+
+    //  std::invalid_argument,    
+    void CheckNewDocumentId(int document_id) const;
+    void CheckNewDocument(int document_id, const std::string_view document) const;
+    //          id  ,   
+    void AddDocumentData(int document_id, DocumentStatus status, int rating);
+    //      id  ,   
+    void RemoveDocumentData(int document_id);
+    void SortDocumentIds();
+    //      .  invalid_argument,   
+    std::vector<int> CollectRemovedOrdinals(const std::vector<int>& document_ids) const;
+    //           
+    void RemoveTermOrdinal(TermId term, int ordinal);
+    //   ,       
+    void FinishRemoval(const std::vector<int>& ordinals);
+    //    SaveSnapshot
+    void WriteSnapshot(std::ostream& output) const;
+    //   ,    ,    .
+    // ordinals -       
+    void DropRemovedSegments(const std::vector<int>& ordinals);
+    //          
+    void PushSealedSegment(std::shared_ptr<const IndexSegment> segment);
+    size_t CountLiveOrdinals(int begin_ordinal, int end_ordinal) const;
+    void AddDocumentBatch(std::execution::sequenced_policy, const std::vector<const DocumentToAdd*>& documents);
+    void AddDocumentBatch(std::execution::parallel_policy, const std::vector<const DocumentToAdd*>& documents);
 
     bool IsStopWord(const std::string_view word) const;
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    bool IsStopTerm(TermId term) const;
+    //    -  words.  false,      
+    bool SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const;
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
     struct QueryWord {
         std::string_view data;
         bool is_minus;
+        //       
+        bool is_required;
         bool is_stop;
     };
 
     QueryWord ParseQueryWord(std::string_view text) const;
+    //    TermDictionary::NO_TERM,        
+    TermId FindTerm(const std::string_view word) const;
+    //  function(postings)       
+    template <typename Function>
+    void ForEachSegmentPostings(TermId term, Function function) const;
+    //        nullptr,     
+    static const double* FindTermFreq(const std::vector<std::pair<TermId, double>>& word_frequencies, TermId term);
+
+    //      ,    
+    struct MatchQuery {
+        //    ; ,      ,  
+        std::vector<std::pair<std::string_view, TermId>> plus_terms;
+        std::vector<TermId> required_terms;
+        std::vector<TermId> minus_terms;
+        //       ,     
+        bool is_unmatchable = false;
+    };
+
+    void ResolveMatchQuery(const std::string_view raw_query, MatchQuery& match_query) const;
+    //    id, out_of_range   id
+    int GetDocumentOrdinal(int document_id) const;
+    //       ordinal;  - O(q log d)     
+    words_and_status_document MatchOrdinal(const MatchQuery& match_query, int ordinal) const;
 
     struct Query {
         std::vector<std::string_view> plus_words;
+        //      plus_words:       
+        std::vector<std::string_view> required_words;
         std::vector<std::string_view> minus_words;
     };
 
-    Query ParseQuery(const std::string_view text, bool sequenced_policy = true) const;
-    // Existence required
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    //        
+    Query ParseQuery(const std::string_view text) const;
+    //    query,    
+    void ParseQuery(const std::string_view text, Query& query) const;
+    static std::string MakeQueryCacheKey(const Query& query, DocumentStatus status, size_t max_result_count);
+    //    ,   
+    void InvalidateQueryCache(int document_id);
+    //        .    ,   
+    // (  )     
+    double ComputeWordInverseDocumentFreq(TermId term) const;
+    //    ,    IDF:      
+    uint64_t GetInverseDocumentFreqVersion() const;
 
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const Query& query, 
+    void SealMutableSegment();
+    //    MERGE_FACTOR     ,    
+    void ScheduleMerge();
+    //    ,  wait   
+    void InstallMerges(bool wait);
+
+    //           
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    void FindTopDocumentsByQuery(ExecutionPolicy policy, QueryContext& context,
+        DocumentPredicate document_predicate, size_t max_result_count) const;
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    void FindAllDocuments(ExecutionPolicy policy, QueryContext& context,
         DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::parallel_policy, const Query& query,
-        DocumentPredicate document_predicate) const;
+    void FindTopDocumentsPruned(QueryContext& context, DocumentPredicate document_predicate, size_t max_result_count) const;
+
+    // - ,   
+    struct QueryTerm {
+        TermId term;
+        double inverse_document_freq;
+        bool is_required;
+    };
+
+    //   -   
+    struct TermCursor {
+        PostingList::Cursor cursor;
+        double inverse_document_freq;
+        //       
+        double max_score;
+        //    - :     ,    
+        size_t word_index;
+        //    
+        size_t document_count;
+    };
+
+    //            (document-at-a-time)
+    struct TermCursors {
+        //      :    
+        std::vector<TermCursor> required;
+        std::vector<TermCursor> optional;
+        std::vector<PostingList::Cursor> minus;
+        //      
+        std::vector<double> word_scores;
+        size_t evaluated_posting_count = 0;
+
+        //   ,      
+        double Score(const TermCursor& term);
+        //   -   ordinal  ,      
+        bool IsExcluded(int ordinal);
+        //             .
+        //     
+        double TakeRelevance();
+    };
+
+    //   FindTopDocuments  .       
+    //        
+    struct StatusPredicate {
+        DocumentStatus status;
+
+        bool operator()(int, DocumentStatus document_status, int) const {
+            return document_status == status;
+        }
+    };
+
+    //      .  false,        
+    bool ResolveQueryTerms(QueryContext& context) const;
+    //         ,     
+    bool IsStatusScanCheaper(const QueryContext& context, DocumentStatus status) const;
+    //  function(ordinal, relevance)      status
+    //    [begin_ordinal, end_ordinal),     
+    template <typename Function>
+    void ScanStatusStripe(const QueryContext& context, DocumentStatus status, TermCursors& cursors,
+        int begin_ordinal, int end_ordinal, Function function) const;
+    //        segment (sealed_segments_.size() -  ).
+    //  false,      -  
+    bool OpenTermCursors(const QueryContext& context, size_t segment, TermCursors& cursors) const;
+    //         function(ordinal, relevance)
+    //      [begin_ordinal, end_ordinal)
+    template <typename Function>
+    void IntersectStripe(const QueryContext& context, TermCursors& cursors, int begin_ordinal, int end_ordinal,
+        Function function) const;
+
+    // ,      
+    struct PostingsQuery {
+        std::vector<std::pair<const PostingList*, double>> plus_postings;
+        std::vector<const PostingList*> minus_postings;
+        // ,     ,     
+        const std::vector<bool>* removed_ordinals = nullptr;
+    };
+
+    //        
+    void ResolvePostings(const QueryContext& context, PostingsQuery& postings_query) const;
+    //       [begin_ordinal, end_ordinal)   stripe
+    //   function(ordinal, relevance)  
+    template <typename Function>
+    static void ScoreStripe(const PostingsQuery& postings_query, ScoreAccumulator& accumulator, size_t stripe,
+        int begin_ordinal, int end_ordinal, Function function);
+    //       
+    static ScoreAccumulator& GetScoreAccumulator();
+    //   FindTopDocuments   
+    static QueryContext& GetQueryContext();
+    static size_t ComputeStripeCount(int ordinal_count);
 
     static bool IsValidWord(const std::string_view word);
 };
 
+//  ,   ,      .
+//     .       
+class SearchServer::QueryContext {
+public:
+    //    -   
+    size_t GetEvaluatedPostingCount() const;
+
+private:
+    friend class SearchServer;
+
+    Query query_;
+    PostingsQuery postings_query_;
+    ScoreAccumulator accumulator_;
+    std::vector<size_t> stripes_;
+    //    ,   
+    std::vector<std::vector<std::pair<int, double>>> stripe_relevances_;
+    std::vector<std::vector<Document>> stripe_documents_;
+    std::vector<Document> documents_;
+    size_t evaluated_posting_count_ = 0;
+
+    //    :  ,   
+    //          
+    std::vector<QueryTerm> query_terms_;
+    std::vector<TermId> minus_terms_;
+    std::vector<TermCursors> stripe_cursors_;
+    std::vector<double> max_score_sums_;
+};
+
+inline double SearchServer::TermCursors::Score(const TermCursor& term) {
+    const double score = term.cursor.GetTermFreq() * term.inverse_document_freq;
+    word_scores[term.word_index] = score;
+    ++evaluated_posting_count;
+    return score;
+}
+
+inline bool SearchServer::TermCursors::IsExcluded(int ordinal) {
+    for (PostingList::Cursor& cursor : minus) {
+        cursor.SkipTo(ordinal);
+        if (!cursor.IsEnd() && cursor.GetOrdinal() == ordinal) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline double SearchServer::TermCursors::TakeRelevance() {
+    double relevance = 0.0;
+    for (double& word_score : word_scores) {
+        relevance += word_score;
+        word_score = 0.0;
+    }
+    return relevance;
+}
+
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
+SearchServer::SearchServer(const StringContainer& stop_words, PostingListFormat posting_list_format)
+    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , posting_list_format_(posting_list_format) {
     bool is_valid_words = std::all_of(stop_words.begin(), stop_words.end(), [this](const auto& word) {
         return IsValidWord(word);
     });
     if (!is_valid_words) {
         throw std::invalid_argument("Stop words contain invalid characters."s);
     }
-}
-
-template <typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const Query query = ParseQuery(raw_query);
-    if (!IsValidWord(raw_query)) {
-        throw std::invalid_argument("The request content contains invalid characters."s);
+    for (const std::string& stop_word : stop_words_) {
+        terms_.Intern(stop_word);
     }
-    std::vector<Document> matched_documents = FindAllDocuments(policy, query, document_predicate);
+    //  -   ,        
+    word_to_document_freqs_.resize(terms_.GetTermCount(), PostingList(posting_list_format_));
+    document_freqs_.resize(terms_.GetTermCount(), 0);
+    inverse_document_freqs_.resize(terms_.GetTermCount());
+}
 
-    sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < DELTA) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
-        }
-    });
+template <typename DocumentRange>
+void SearchServer::AddDocuments(const DocumentRange& documents) {
+    AddDocuments(std::execution::seq, documents);
+}
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename ExecutionPolicy, typename DocumentRange>
+void SearchServer::AddDocuments(ExecutionPolicy policy, const DocumentRange& documents) {
+    std::vector<const DocumentToAdd*> document_pointers;
+    for (const DocumentToAdd& document : documents) {
+        document_pointers.push_back(&document);
     }
-    return matched_documents;
+    AddDocumentBatch(policy, document_pointers);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentPredicate document_predicate,
+    size_t max_result_count) const {
+    QueryContext& context = GetQueryContext();
+    ParseQuery(raw_query, context.query_);
+    FindTopDocumentsByQuery(policy, context, document_predicate, max_result_count);
+    return context.documents_;
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate,
+    size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
 }
 
 template <typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
+    const StatusPredicate document_predicate{ status };
+    if (!query_cache_) {
+        return FindTopDocuments(policy, raw_query, document_predicate, max_result_count);
+    }
+    QueryContext& context = GetQueryContext();
+    ParseQuery(raw_query, context.query_);
+    std::string key = MakeQueryCacheKey(context.query_, status, max_result_count);
+    if (std::optional<std::vector<Document>> cached_documents = query_cache_->Find(key, GetInverseDocumentFreqVersion())) {
+        return std::move(*cached_documents);
+    }
+    FindTopDocumentsByQuery(policy, context, document_predicate, max_result_count);
+    query_cache_->Insert(std::move(key), GetInverseDocumentFreqVersion(), context.documents_);
+    return context.documents_;
 }
 
 template <typename ExecutionPolicy>
@@ -156,72 +563,316 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, con
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy, const SearchServer::Query& query,
-    DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+template <typename ExecutionPolicy, typename DocumentPredicate>
+void SearchServer::FindTopDocumentsByQuery(ExecutionPolicy policy, QueryContext& context,
+    DocumentPredicate document_predicate, size_t max_result_count) const {
+    context.documents_.clear();
+    context.evaluated_posting_count_ = 0;
+    if (!ResolveQueryTerms(context)) {
+        return;
+    }
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        //             
+        bool is_status_scan = false;
+        if constexpr (std::is_same_v<DocumentPredicate, StatusPredicate>) {
+            is_status_scan = IsStatusScanCheaper(context, document_predicate.status);
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
-            }
+        if (is_dynamic_pruning_enabled_ && context.query_.required_words.empty() && !is_status_scan) {
+            FindTopDocumentsPruned(context, document_predicate, max_result_count);
+            return;
         }
     }
+    FindAllDocuments(policy, context, document_predicate);
+    SelectTopDocuments(policy, context.documents_, max_result_count, IsMoreRelevant);
+}
 
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+template <typename ExecutionPolicy, typename DocumentPredicate>
+void SearchServer::FindAllDocuments(ExecutionPolicy policy, QueryContext& context,
+    DocumentPredicate document_predicate) const {
+    //      ,      
+    //  ,       
+    bool is_status_scan = false;
+    if constexpr (std::is_same_v<DocumentPredicate, StatusPredicate>) {
+        is_status_scan = IsStatusScanCheaper(context, document_predicate.status);
+    }
+    const bool is_conjunctive = !is_status_scan && !context.query_.required_words.empty();
+    const bool is_accumulated = !is_status_scan && !is_conjunctive;
+    PostingsQuery& postings_query = context.postings_query_;
+    context.evaluated_posting_count_ = 0;
+    if (is_accumulated) {
+        ResolvePostings(context, postings_query);
+        for (const auto& [postings, inverse_document_freq] : postings_query.plus_postings) {
+            context.evaluated_posting_count_ += postings->GetDocumentCount();
+        }
+    }
+
+    const int ordinal_count = static_cast<int>(document_ids_by_ordinal_.size());
+    const size_t stripe_count = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>
+        ? ComputeStripeCount(ordinal_count) : 1;
+    std::vector<size_t>& stripes = context.stripes_;
+    stripes.resize(stripe_count);
+    std::iota(stripes.begin(), stripes.end(), 0);
+
+    //  -    ,    
+    auto& stripe_relevances = context.stripe_relevances_;
+    auto& stripe_documents = context.stripe_documents_;
+    if (stripe_relevances.size() < stripe_count) {
+        stripe_relevances.resize(stripe_count);
+        stripe_documents.resize(stripe_count);
+    }
+    ScoreAccumulator& accumulator = context.accumulator_;
+    if (is_accumulated) {
+        accumulator.Prepare(ordinal_count, stripe_count);
+    } else if (context.stripe_cursors_.size() < stripe_count) {
+        context.stripe_cursors_.resize(stripe_count);
+    }
+    std::for_each(policy, stripes.begin(), stripes.end(), [&](size_t stripe) {
+        const int begin_ordinal = static_cast<int>(static_cast<int64_t>(ordinal_count) * stripe / stripe_count);
+        const int end_ordinal = static_cast<int>(static_cast<int64_t>(ordinal_count) * (stripe + 1) / stripe_count);
+        stripe_relevances[stripe].clear();
+        const auto add_document = [&stripe_relevances, stripe](int ordinal, double relevance) {
+            stripe_relevances[stripe].push_back({ ordinal, relevance });
+        };
+        if constexpr (std::is_same_v<DocumentPredicate, StatusPredicate>) {
+            if (is_status_scan) {
+                ScanStatusStripe(context, document_predicate.status, context.stripe_cursors_[stripe], begin_ordinal, end_ordinal,
+                    add_document);
+                return;
+            }
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        if (is_conjunctive) {
+            IntersectStripe(context, context.stripe_cursors_[stripe], begin_ordinal, end_ordinal, add_document);
+        } else {
+            ScoreStripe(postings_query, accumulator, stripe, begin_ordinal, end_ordinal, add_document);
+        }
+    });
+    if (!is_accumulated) {
+        for (size_t stripe = 0; stripe < stripe_count; ++stripe) {
+            context.evaluated_posting_count_ += context.stripe_cursors_[stripe].evaluated_posting_count;
         }
     }
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    //      ,     
+    std::for_each(policy, stripes.begin(), stripes.end(), [&](size_t stripe) {
+        stripe_documents[stripe].clear();
+        for (const auto& [ordinal, relevance] : stripe_relevances[stripe]) {
+            const int document_id = document_ids_by_ordinal_[ordinal];
+            const int rating = document_ratings_by_ordinal_[ordinal];
+            if (document_predicate(document_id, document_statuses_by_ordinal_[ordinal], rating)) {
+                stripe_documents[stripe].push_back({ document_id, relevance, rating });
+            }
+        }
+    });
+
+    context.documents_.clear();
+    for (size_t stripe = 0; stripe < stripe_count; ++stripe) {
+        context.documents_.insert(context.documents_.end(), stripe_documents[stripe].begin(), stripe_documents[stripe].end());
     }
-    return matched_documents;
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_policy policy, const Query& query,
-    DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(std::thread::hardware_concurrency());
-
-    for_each(policy, query.plus_words.begin(), query.plus_words.end(), 
-        [&] (const std::string_view word) {
-            if (word_to_document_freqs_.count(word) != 0) {
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for_each(word_to_document_freqs_.at(word).begin(), word_to_document_freqs_.at(word).end(),
-                    [this, &document_to_relevance, inverse_document_freq, document_predicate]
-                        (const std::pair<int, double> relevance_doc) {
-                        const auto& document_data = documents_.at(relevance_doc.first);
-                        if (document_predicate(relevance_doc.first, document_data.status, document_data.rating)) {
-                            document_to_relevance[relevance_doc.first] += relevance_doc.second * inverse_document_freq;
-                        }
-                    });
-            }
+void SearchServer::FindTopDocumentsPruned(QueryContext& context, DocumentPredicate document_predicate,
+    size_t max_result_count) const {
+    //        
+    std::vector<Document>& top_documents = context.documents_;
+    top_documents.clear();
+    if (max_result_count == 0) {
+        return;
+    }
+    if (context.stripe_cursors_.empty()) {
+        context.stripe_cursors_.resize(1);
+    }
+    TermCursors& term_cursors = context.stripe_cursors_.front();
+    term_cursors.evaluated_posting_count = 0;
+    std::vector<TermCursor>& cursors = term_cursors.optional;
+    std::vector<double>& max_score_sums = context.max_score_sums_;
+    //          
+    double threshold = -std::numeric_limits<double>::infinity();
+    //       ,        
+    for (size_t segment = 0; segment <= sealed_segments_.size(); ++segment) {
+        OpenTermCursors(context, segment, term_cursors);
+        std::sort(cursors.begin(), cursors.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+            return lhs.max_score < rhs.max_score;
         });
+        max_score_sums.assign(1, 0.0);
+        for (const TermCursor& term : cursors) {
+            max_score_sums.push_back(max_score_sums.back() + term.max_score);
+        }
+        // ,      first_essential ,   ,
+        //      () 
+        size_t first_essential = 0;
+        const auto update_first_essential = [&] {
+            while (first_essential < cursors.size() && max_score_sums[first_essential + 1] < threshold) {
+                ++first_essential;
+            }
+        };
+        update_first_essential();
+        while (true) {
+            int candidate = std::numeric_limits<int>::max();
+            for (size_t i = first_essential; i < cursors.size(); ++i) {
+                if (!cursors[i].cursor.IsEnd()) {
+                    candidate = std::min(candidate, cursors[i].cursor.GetOrdinal());
+                }
+            }
+            if (candidate == std::numeric_limits<int>::max()) {
+                break;
+            }
+            double score = 0.0;
+            for (size_t i = first_essential; i < cursors.size(); ++i) {
+                TermCursor& term = cursors[i];
+                if (!term.cursor.IsEnd() && term.cursor.GetOrdinal() == candidate) {
+                    score += term_cursors.Score(term);
+                    term.cursor.Next();
+                }
+            }
+            //   -     ,     
+            bool is_competitive = true;
+            for (size_t i = first_essential; i-- > 0;) {
+                TermCursor& term = cursors[i];
+                if (score + max_score_sums[i] + term.cursor.GetBlockMaxTermFreq(candidate) * term.inverse_document_freq < threshold) {
+                    is_competitive = false;
+                    break;
+                }
+                term.cursor.SkipTo(candidate);
+                if (!term.cursor.IsEnd() && term.cursor.GetOrdinal() == candidate) {
+                    score += term_cursors.Score(term);
+                }
+            }
+            const double relevance = term_cursors.TakeRelevance();
+            if (!is_competitive || removed_ordinals_[candidate] || term_cursors.IsExcluded(candidate)) {
+                continue;
+            }
+            const int document_id = document_ids_by_ordinal_[candidate];
+            const Document document(document_id, relevance, document_ratings_by_ordinal_[candidate]);
+            if ((top_documents.size() < max_result_count || IsMoreRelevant(document, top_documents.front()))
+                && document_predicate(document_id, document_statuses_by_ordinal_[candidate], document.rating)) {
+                top_documents.push_back(document);
+                std::push_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+                if (top_documents.size() > max_result_count) {
+                    std::pop_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+                    top_documents.pop_back();
+                }
+                if (top_documents.size() == max_result_count) {
+                    threshold = top_documents.front().relevance - DELTA - PRUNING_TOLERANCE;
+                    update_first_essential();
+                }
+            }
+        }
+    }
+    context.evaluated_posting_count_ = term_cursors.evaluated_posting_count;
+    std::sort_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+}
 
-    for_each(policy, query.minus_words.begin(), query.minus_words.end(), 
-        [&] (const std::string_view word) {
-            if (word_to_document_freqs_.count(word) != 0) {
-                for_each(word_to_document_freqs_.at(word).begin(), word_to_document_freqs_.at(word).end(), 
-                    [&document_to_relevance] (const std::pair<int, double> relevance_doc) {
-                        document_to_relevance.Erase(relevance_doc.first);
-                    });
+template <typename Function>
+void SearchServer::IntersectStripe(const QueryContext& context, TermCursors& cursors, int begin_ordinal, int end_ordinal,
+    Function function) const {
+    cursors.evaluated_posting_count = 0;
+    const int ordinal_count = static_cast<int>(document_ids_by_ordinal_.size());
+    for (size_t segment = 0; segment <= sealed_segments_.size(); ++segment) {
+        const bool is_sealed = segment < sealed_segments_.size();
+        const int segment_begin = is_sealed ? sealed_segments_[segment]->GetBeginOrdinal() : mutable_begin_ordinal_;
+        const int segment_end = is_sealed ? sealed_segments_[segment]->GetEndOrdinal() : ordinal_count;
+        if (segment_end <= begin_ordinal || segment_begin >= end_ordinal || !OpenTermCursors(context, segment, cursors)) {
+            continue;
+        }
+        std::vector<TermCursor>& required = cursors.required;
+        PostingList::Cursor& lead = required.front().cursor;
+        lead.SkipTo(begin_ordinal);
+        while (!lead.IsEnd() && lead.GetOrdinal() < end_ordinal) {
+            //     ,     
+            //   
+            const int candidate = lead.GetOrdinal();
+            int next_candidate = candidate;
+            for (size_t i = 1; i < required.size() && next_candidate == candidate; ++i) {
+                required[i].cursor.SkipTo(candidate);
+                next_candidate = required[i].cursor.IsEnd() ? std::numeric_limits<int>::max() : required[i].cursor.GetOrdinal();
+            }
+            if (next_candidate != candidate) {
+                lead.SkipTo(next_candidate);
+                continue;
             }
+            if (!removed_ordinals_[candidate] && !cursors.IsExcluded(candidate)) {
+                for (const TermCursor& term : required) {
+                    cursors.Score(term);
+                }
+                for (TermCursor& term : cursors.optional) {
+                    term.cursor.SkipTo(candidate);
+                    if (!term.cursor.IsEnd() && term.cursor.GetOrdinal() == candidate) {
+                        cursors.Score(term);
+                    }
+                }
+                function(candidate, cursors.TakeRelevance());
+            }
+            lead.Next();
+        }
+    }
+}
+
+template <typename Function>
+void SearchServer::ScanStatusStripe(const QueryContext& context, DocumentStatus status, TermCursors& cursors,
+    int begin_ordinal, int end_ordinal, Function function) const {
+    cursors.evaluated_posting_count = 0;
+    const std::vector<int>& ordinals = status_partitions_[static_cast<size_t>(status)].ordinals;
+    for (auto ordinal = std::lower_bound(ordinals.begin(), ordinals.end(), begin_ordinal);
+        ordinal != ordinals.end() && *ordinal < end_ordinal; ++ordinal) {
+        if (removed_ordinals_[*ordinal]) {
+            continue;
+        }
+        const auto& word_frequencies = word_frequencies_in_document_[*ordinal];
+        const auto find_term_freq = [&word_frequencies](TermId term) {
+            return FindTermFreq(word_frequencies, term);
+        };
+        if (std::any_of(context.minus_terms_.begin(), context.minus_terms_.end(), find_term_freq)) {
+            continue;
+        }
+        //       ,       ,
+        //    ,    
+        double relevance = 0.0;
+        bool is_matched = false;
+        for (const QueryTerm& query_term : context.query_terms_) {
+            if (const double* term_freq = find_term_freq(query_term.term)) {
+                relevance += *term_freq * query_term.inverse_document_freq;
+                is_matched = true;
+                ++cursors.evaluated_posting_count;
+            } else if (query_term.is_required) {
+                is_matched = false;
+                break;
+            }
+        }
+        if (is_matched) {
+            function(*ordinal, relevance);
+        }
+    }
+}
+
+template <typename Function>
+void SearchServer::ScoreStripe(const PostingsQuery& postings_query, ScoreAccumulator& accumulator, size_t stripe,
+    int begin_ordinal, int end_ordinal, Function function) {
+    for (const PostingList* postings : postings_query.minus_postings) {
+        postings->ForEach(begin_ordinal, end_ordinal, [&](int ordinal, double) {
+            accumulator.Exclude(stripe, ordinal);
         });
+    }
+    for (const auto& [postings, inverse_document_freq] : postings_query.plus_postings) {
+        postings->ForEach(begin_ordinal, end_ordinal, [&, inverse_document_freq = inverse_document_freq](int ordinal, double term_freq) {
+            accumulator.Add(stripe, ordinal, term_freq * inverse_document_freq);
+        });
+    }
+    accumulator.Drain(stripe, [&](int ordinal, double relevance) {
+        if (!(*postings_query.removed_ordinals)[ordinal]) {
+            function(ordinal, relevance);
+        }
+    });
+}
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+template <typename Function>
+void SearchServer::ForEachSegmentPostings(TermId term, Function function) const {
+    for (const auto& segment : sealed_segments_) {
+        if (const PostingList* postings = segment->FindPostings(term)) {
+            function(*postings);
+        }
+    }
+    if (!word_to_document_freqs_[term].IsEmpty()) {
+        function(word_to_document_freqs_[term]);
     }
-    return matched_documents;
 }
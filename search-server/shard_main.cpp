@@ -0,0 +1,24 @@
+#include "search_server.h"
+#include "shard_rpc.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Процесс одного шарда: SearchServerShard <путь к сокету> [стоп-слова через пробел]
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: "s << argv[0] << " <socket path> [stop words]"s << endl;
+        return 1;
+    }
+    try {
+        SearchServer search_server(argc == 3 ? string(argv[2]) : string());
+        ServeShard(search_server, argv[1]);
+    } catch (const exception& error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include "shard_protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SEARCH_SERVER_HAS_UNIX_SOCKETS
+#endif
+
+using namespace std;
+
+void FrameWriter::BeginFrame(uint32_t request_id, ShardMessageType type) {
+    frame_begin_ = bytes_.size();
+    Write<uint32_t>(0);
+    Write(request_id);
+    Write(type);
+}
+
+void FrameWriter::WriteString(string_view text) {
+    Write(static_cast<uint32_t>(text.size()));
+    WriteBytes(text.data(), text.size());
+}
+
+void FrameWriter::EndFrame() {
+    const uint32_t body_size = static_cast<uint32_t>(bytes_.size() - frame_begin_ - FrameHeader::SIZE);
+    memcpy(bytes_.data() + frame_begin_, &body_size, sizeof(body_size));
+}
+
+const char* FrameWriter::GetData() const {
+    return bytes_.data();
+}
+
+size_t FrameWriter::GetSize() const {
+    return bytes_.size();
+}
+
+void FrameWriter::Clear() {
+    bytes_.clear();
+    frame_begin_ = 0;
+}
+
+void FrameWriter::WriteBytes(const void* data, size_t size) {
+    const char* const bytes = static_cast<const char*>(data);
+    bytes_.insert(bytes_.end(), bytes, bytes + size);
+}
+
+FrameReader::FrameReader(const char* data, size_t size)
+    : data_(data)
+    , size_(size) {
+}
+
+string_view FrameReader::ReadString() {
+    const uint32_t size = Read<uint32_t>();
+    return string_view(ReadBytes(size), size);
+}
+
+bool FrameReader::IsEnd() const {
+    return position_ == size_;
+}
+
+const char* FrameReader::ReadBytes(size_t size) {
+    if (size > size_ - position_) {
+        throw invalid_argument("The frame is truncated or corrupted."s);
+    }
+    const char* const bytes = data_ + position_;
+    position_ += size;
+    return bytes;
+}
+
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+namespace {
+    sockaddr_un MakeSocketAddress(const string& socket_path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+            throw invalid_argument("The socket path is empty or too long: "s + socket_path);
+        }
+        copy(socket_path.begin(), socket_path.end(), address.sun_path);
+        return address;
+    }
+} // namespace
+#endif
+
+SocketConnection::SocketConnection(int descriptor)
+    : descriptor_(descriptor) {
+}
+
+SocketConnection::~SocketConnection() {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    close(descriptor_);
+#endif
+}
+
+unique_ptr<SocketConnection> SocketConnection::Connect(const string& socket_path, chrono::milliseconds timeout) {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    const sockaddr_un address = MakeSocketAddress(socket_path);
+    const auto deadline = chrono::steady_clock::now() + timeout;
+    while (true) {
+        const int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (descriptor < 0) {
+            throw runtime_error("Cannot create a socket"s);
+        }
+        if (connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+            return make_unique<SocketConnection>(descriptor);
+        }
+        const int error = errno;
+        close(descriptor);
+        // шард мог ещё не создать сокет или не начать его слушать
+        if ((error != ENOENT && error != ECONNREFUSED) || chrono::steady_clock::now() >= deadline) {
+            throw runtime_error("Cannot connect to "s + socket_path);
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+#else
+    throw runtime_error("Unix domain sockets are not supported on this platform"s);
+#endif
+}
+
+FrameWriter& SocketConnection::GetWriter() {
+    return writer_;
+}
+
+void SocketConnection::Flush() {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    // закрытый собеседник не должен завершать процесс сигналом SIGPIPE
+#ifdef MSG_NOSIGNAL
+    constexpr int SEND_FLAGS = MSG_NOSIGNAL | MSG_DONTWAIT;
+#else
+    constexpr int SEND_FLAGS = MSG_DONTWAIT;
+#endif
+    const char* data = writer_.GetData();
+    size_t size = writer_.GetSize();
+    // собеседник может сам писать в ответ и ждать, пока его прочтут, поэтому, пока в сокете нет места,
+    // входящие данные дочитываются в буфер чтения. Иначе обе стороны остановятся на заполненных буферах сокета
+    bool is_peer_open = true;
+    while (size > 0) {
+        const ssize_t sent = send(descriptor_, data, size, SEND_FLAGS);
+        if (sent >= 0) {
+            data += sent;
+            size -= static_cast<size_t>(sent);
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw runtime_error("Cannot write to the socket"s);
+        }
+        pollfd events{ descriptor_, static_cast<short>(is_peer_open ? POLLIN | POLLOUT : POLLOUT), 0 };
+        if (poll(&events, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error("Cannot wait for the socket"s);
+        }
+        if (is_peer_open && (events.revents & POLLIN) != 0) {
+            is_peer_open = ReadMore();
+        }
+    }
+#endif
+    writer_.Clear();
+}
+
+bool SocketConnection::ReadFrame(FrameHeader& header, FrameReader& body) {
+    while (!HasBufferedFrame()) {
+        if (!ReadMore()) {
+            if (read_begin_ == read_end_) {
+                return false;
+            }
+            throw runtime_error("The connection was closed in the middle of a frame"s);
+        }
+    }
+    PeekHeader(header);
+    body = FrameReader(read_buffer_.data() + read_begin_ + FrameHeader::SIZE, header.body_size);
+    read_begin_ += FrameHeader::SIZE + header.body_size;
+    return true;
+}
+
+bool SocketConnection::HasBufferedFrame() const {
+    FrameHeader header;
+    return PeekHeader(header) && read_end_ - read_begin_ >= FrameHeader::SIZE + header.body_size;
+}
+
+bool SocketConnection::PeekHeader(FrameHeader& header) const {
+    if (read_end_ - read_begin_ < FrameHeader::SIZE) {
+        return false;
+    }
+    FrameReader reader(read_buffer_.data() + read_begin_, FrameHeader::SIZE);
+    header.body_size = reader.Read<uint32_t>();
+    header.request_id = reader.Read<uint32_t>();
+    header.type = reader.Read<ShardMessageType>();
+    if (header.body_size > FrameHeader::MAX_BODY_SIZE || header.type > ShardMessageType::ERROR) {
+        throw invalid_argument("The frame is truncated or corrupted."s);
+    }
+    return true;
+}
+
+bool SocketConnection::ReadMore() {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    // непрочитанный остаток переносится в начало, буфер растёт, только если кадр в него не помещается
+    if (read_begin_ > 0) {
+        copy(read_buffer_.begin() + read_begin_, read_buffer_.begin() + read_end_, read_buffer_.begin());
+        read_end_ -= read_begin_;
+        read_begin_ = 0;
+    }
+    if (read_buffer_.size() - read_end_ < READ_CHUNK_SIZE) {
+        read_buffer_.resize(max(read_buffer_.size() * 2, read_end_ + READ_CHUNK_SIZE));
+    }
+    while (true) {
+        const ssize_t received = recv(descriptor_, read_buffer_.data() + read_end_, read_buffer_.size() - read_end_, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error("Cannot read from the socket"s);
+        }
+        read_end_ += static_cast<size_t>(received);
+        return received > 0;
+    }
+#else
+    return false;
+#endif
+}
+
+SocketListener::SocketListener(const string& socket_path)
+    : socket_path_(socket_path) {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    const sockaddr_un address = MakeSocketAddress(socket_path);
+    // файл мог остаться от процесса, завершившегося аварийно
+    unlink(socket_path.c_str());
+    descriptor_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor_ < 0) {
+        throw runtime_error("Cannot create a socket"s);
+    }
+    if (bind(descriptor_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || listen(descriptor_, SOMAXCONN) != 0) {
+        close(descriptor_);
+        throw runtime_error("Cannot listen on "s + socket_path);
+    }
+#else
+    throw runtime_error("Unix domain sockets are not supported on this platform"s);
+#endif
+}
+
+SocketListener::~SocketListener() {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    close(descriptor_);
+    unlink(socket_path_.c_str());
+#endif
+}
+
+unique_ptr<SocketConnection> SocketListener::Accept() {
+#ifdef SEARCH_SERVER_HAS_UNIX_SOCKETS
+    while (true) {
+        const int descriptor = accept(descriptor_, nullptr, nullptr);
+        if (descriptor >= 0) {
+            return make_unique<SocketConnection>(descriptor);
+        }
+        if (errno != EINTR) {
+            throw runtime_error("Cannot accept a connection on "s + socket_path_);
+        }
+    }
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using namespace std::string_literals;
+
+// Виды кадров протокола шардов. Ответ на запрос имеет тот же вид или ERROR
+enum class ShardMessageType : uint8_t {
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+    FIND_TOP_DOCUMENTS,
+    MATCH_DOCUMENT,
+    SHUTDOWN,
+    ERROR,
+};
+
+// Вид исключения, которым шард ответил на запрос; клиент бросает исключение того же вида
+enum class ShardErrorKind : uint8_t {
+    INVALID_ARGUMENT,
+    OUT_OF_RANGE,
+    RUNTIME_ERROR,
+};
+
+// Заголовок кадра: длина тела, номер запроса и вид. Номер ответа совпадает с номером запроса
+struct FrameHeader {
+    static constexpr size_t SIZE = sizeof(uint32_t) * 2 + sizeof(uint8_t);
+    // кадр длиннее считается повреждённым
+    static constexpr uint32_t MAX_BODY_SIZE = 64 * 1024 * 1024;
+
+    uint32_t body_size = 0;
+    uint32_t request_id = 0;
+    ShardMessageType type = ShardMessageType::ERROR;
+};
+
+// Запись кадров подряд в один буфер. Числа пишутся без выравнивания в порядке байтов машины:
+// протокол связывает только процессы одного хоста
+class FrameWriter {
+public:
+    void BeginFrame(uint32_t request_id, ShardMessageType type);
+    template <typename Value>
+    void Write(const Value& value);
+    // Длина uint32, затем байты
+    void WriteString(std::string_view text);
+    // Дописывает в заголовок длину тела
+    void EndFrame();
+
+    const char* GetData() const;
+    size_t GetSize() const;
+    void Clear();
+
+private:
+    std::vector<char> bytes_;
+    size_t frame_begin_ = 0;
+
+    void WriteBytes(const void* data, size_t size);
+};
+
+// Чтение тела кадра. Выход за границы тела бросает std::invalid_argument
+class FrameReader {
+public:
+    FrameReader() = default;
+    FrameReader(const char* data, size_t size);
+
+    template <typename Value>
+    Value Read();
+    // Строка указывает в буфер соединения и действительна до следующего чтения кадра
+    std::string_view ReadString();
+    bool IsEnd() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+
+    const char* ReadBytes(size_t size);
+};
+
+// Соединение по сокету Unix с буферами кадров. Запросы копятся в буфере записи и уходят одним вызовом Flush,
+// а чтение забирает из сокета столько данных, сколько есть, поэтому несколько кадров разбираются без системных вызовов.
+// Ошибки ввода-вывода бросают std::runtime_error
+class SocketConnection {
+public:
+    explicit SocketConnection(int descriptor);
+    ~SocketConnection();
+
+    SocketConnection(const SocketConnection&) = delete;
+    SocketConnection& operator=(const SocketConnection&) = delete;
+
+    // Пока сокет ещё не слушают, попытки повторяются до истечения timeout
+    static std::unique_ptr<SocketConnection> Connect(const std::string& socket_path, std::chrono::milliseconds timeout);
+
+    FrameWriter& GetWriter();
+    // Пока запись ждёт места в сокете, входящие кадры дочитываются в буфер и потом возвращаются ReadFrame
+    void Flush();
+    // Ждёт следующий кадр. false, если собеседник закрыл соединение между кадрами.
+    // Тело действительно до следующего вызова ReadFrame или Flush
+    bool ReadFrame(FrameHeader& header, FrameReader& body);
+    // Полный кадр уже прочитан из сокета и ждёт в буфере
+    bool HasBufferedFrame() const;
+
+private:
+    static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    int descriptor_ = -1;
+    FrameWriter writer_;
+    std::vector<char> read_buffer_;
+    size_t read_begin_ = 0;
+    size_t read_end_ = 0;
+
+    // Разбирает заголовок, если он целиком в буфере
+    bool PeekHeader(FrameHeader& header) const;
+    // false, если сокет закрыт
+    bool ReadMore();
+};
+
+// Слушающий сокет Unix. Файл сокета удаляется перед привязкой и при разрушении
+class SocketListener {
+public:
+    explicit SocketListener(const std::string& socket_path);
+    ~SocketListener();
+
+    SocketListener(const SocketListener&) = delete;
+    SocketListener& operator=(const SocketListener&) = delete;
+
+    std::unique_ptr<SocketConnection> Accept();
+
+private:
+    std::string socket_path_;
+    int descriptor_ = -1;
+};
+
+template <typename Value>
+void FrameWriter::Write(const Value& value) {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    WriteBytes(&value, sizeof(value));
+}
+
+template <typename Value>
+Value FrameReader::Read() {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    Value value;
+    std::memcpy(&value, ReadBytes(sizeof(value)), sizeof(value));
+    return value;
+}
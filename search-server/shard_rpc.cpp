@@ -0,0 +1,410 @@
+#include "shard_rpc.h"
+#include "sharded_search_server.h"
+#include "string_processing.h"
+#include "top_documents.h"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+    DocumentStatus ReadStatus(FrameReader& reader) {
+        const uint8_t status = reader.Read<uint8_t>();
+        if (status > static_cast<uint8_t>(DocumentStatus::REMOVED)) {
+            throw invalid_argument("The frame is truncated or corrupted."s);
+        }
+        return static_cast<DocumentStatus>(status);
+    }
+
+    template <typename StringContainer>
+    void WriteStrings(FrameWriter& writer, const StringContainer& strings) {
+        writer.Write(static_cast<uint32_t>(strings.size()));
+        for (const string_view text : strings) {
+            writer.WriteString(text);
+        }
+    }
+
+    vector<string> ReadStrings(FrameReader& reader) {
+        vector<string> strings(reader.Read<uint32_t>());
+        for (string& text : strings) {
+            text = string(reader.ReadString());
+        }
+        return strings;
+    }
+
+    vector<string_view> GetDocumentWords(const SearchServer& search_server, int document_id) {
+        vector<string_view> words;
+        for (const auto& [word, freq] : search_server.GetWordFrequencies(document_id)) {
+            words.push_back(word);
+        }
+        return words;
+    }
+
+    // Выполняет запрос и дописывает ответ в writer. Исключение до записи ответа означает ошибку запроса
+    void HandleRequest(SearchServer& search_server, CorpusStatistics& statistics, const FrameHeader& header,
+        FrameReader& request, FrameWriter& writer) {
+        switch (header.type) {
+        case ShardMessageType::ADD_DOCUMENT: {
+            const int document_id = request.Read<int32_t>();
+            const DocumentStatus status = ReadStatus(request);
+            vector<int> ratings(request.Read<uint32_t>());
+            for (int& rating : ratings) {
+                rating = request.Read<int32_t>();
+            }
+            const string_view document = request.ReadString();
+            search_server.AddDocument(document_id, document, status, ratings);
+            writer.BeginFrame(header.request_id, header.type);
+            WriteStrings(writer, GetDocumentWords(search_server, document_id));
+            break;
+        }
+        case ShardMessageType::REMOVE_DOCUMENT: {
+            const int document_id = request.Read<int32_t>();
+            // строки слов остаются в словаре сервера и после удаления документа
+            const vector<string_view> words = GetDocumentWords(search_server, document_id);
+            search_server.RemoveDocument(document_id);
+            writer.BeginFrame(header.request_id, header.type);
+            WriteStrings(writer, words);
+            break;
+        }
+        case ShardMessageType::FIND_TOP_DOCUMENTS: {
+            const string_view raw_query = request.ReadString();
+            const DocumentStatus status = ReadStatus(request);
+            const size_t max_result_count = request.Read<uint32_t>();
+            const int document_count = request.Read<int32_t>();
+            vector<pair<string_view, uint32_t>> document_freqs(request.Read<uint32_t>());
+            for (auto& [word, document_freq] : document_freqs) {
+                word = request.ReadString();
+                document_freq = request.Read<uint32_t>();
+            }
+            statistics.SetDocumentFreqs(document_count, document_freqs);
+            const vector<Document> documents = search_server.FindTopDocuments(raw_query, status, max_result_count);
+            writer.BeginFrame(header.request_id, header.type);
+            writer.Write(static_cast<uint32_t>(documents.size()));
+            for (const Document& document : documents) {
+                writer.Write<int32_t>(document.id);
+                writer.Write(document.relevance);
+                writer.Write<int32_t>(document.rating);
+            }
+            break;
+        }
+        case ShardMessageType::MATCH_DOCUMENT: {
+            const string_view raw_query = request.ReadString();
+            const int document_id = request.Read<int32_t>();
+            const auto [words, status] = search_server.MatchDocument(raw_query, document_id);
+            writer.BeginFrame(header.request_id, header.type);
+            WriteStrings(writer, words);
+            writer.Write(static_cast<uint8_t>(status));
+            break;
+        }
+        case ShardMessageType::SHUTDOWN:
+            writer.BeginFrame(header.request_id, header.type);
+            break;
+        default:
+            throw invalid_argument("Unknown request type."s);
+        }
+        writer.EndFrame();
+    }
+
+    void WriteError(FrameWriter& writer, uint32_t request_id, ShardErrorKind kind, const char* message) {
+        writer.BeginFrame(request_id, ShardMessageType::ERROR);
+        writer.Write(kind);
+        writer.WriteString(message);
+        writer.EndFrame();
+    }
+} // namespace
+
+void ServeShard(SearchServer& search_server, const string& socket_path) {
+    SocketListener listener(socket_path);
+    const auto statistics = make_shared<CorpusStatistics>();
+    search_server.SetCorpusStatistics(statistics);
+    bool is_stopping = false;
+    while (!is_stopping) {
+        const unique_ptr<SocketConnection> connection = listener.Accept();
+        FrameHeader header;
+        FrameReader request;
+        try {
+            while (!is_stopping && connection->ReadFrame(header, request)) {
+                FrameWriter& writer = connection->GetWriter();
+                try {
+                    HandleRequest(search_server, *statistics, header, request, writer);
+                } catch (const invalid_argument& error) {
+                    WriteError(writer, header.request_id, ShardErrorKind::INVALID_ARGUMENT, error.what());
+                } catch (const out_of_range& error) {
+                    WriteError(writer, header.request_id, ShardErrorKind::OUT_OF_RANGE, error.what());
+                } catch (const exception& error) {
+                    WriteError(writer, header.request_id, ShardErrorKind::RUNTIME_ERROR, error.what());
+                }
+                is_stopping = header.type == ShardMessageType::SHUTDOWN;
+                // ответы на запросы, пришедшие вместе, уходят одной записью
+                if (is_stopping || !connection->HasBufferedFrame()) {
+                    connection->Flush();
+                }
+            }
+        } catch (const exception&) {
+            // сбой соединения не останавливает шард: он ждёт следующего подключения
+        }
+    }
+    search_server.SetCorpusStatistics(nullptr);
+}
+
+ShardClient::ShardClient(const string& socket_path)
+    : connection_(SocketConnection::Connect(socket_path, CONNECT_TIMEOUT)) {
+}
+
+void ShardClient::SendAddDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) {
+    FrameWriter& writer = BeginRequest(ShardMessageType::ADD_DOCUMENT);
+    writer.Write<int32_t>(document_id);
+    writer.Write(static_cast<uint8_t>(status));
+    writer.Write(static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        writer.Write<int32_t>(rating);
+    }
+    writer.WriteString(document);
+    writer.EndFrame();
+}
+
+void ShardClient::SendRemoveDocument(int document_id) {
+    FrameWriter& writer = BeginRequest(ShardMessageType::REMOVE_DOCUMENT);
+    writer.Write<int32_t>(document_id);
+    writer.EndFrame();
+}
+
+void ShardClient::SendFindTopDocuments(const string_view raw_query, DocumentStatus status, size_t max_result_count,
+    int document_count, const vector<pair<string_view, uint32_t>>& document_freqs) {
+    FrameWriter& writer = BeginRequest(ShardMessageType::FIND_TOP_DOCUMENTS);
+    writer.WriteString(raw_query);
+    writer.Write(static_cast<uint8_t>(status));
+    writer.Write(static_cast<uint32_t>(min<size_t>(max_result_count, numeric_limits<uint32_t>::max())));
+    writer.Write<int32_t>(document_count);
+    writer.Write(static_cast<uint32_t>(document_freqs.size()));
+    for (const auto& [word, document_freq] : document_freqs) {
+        writer.WriteString(word);
+        writer.Write(document_freq);
+    }
+    writer.EndFrame();
+}
+
+void ShardClient::SendMatchDocument(const string_view raw_query, int document_id) {
+    FrameWriter& writer = BeginRequest(ShardMessageType::MATCH_DOCUMENT);
+    writer.WriteString(raw_query);
+    writer.Write<int32_t>(document_id);
+    writer.EndFrame();
+}
+
+void ShardClient::SendShutdown() {
+    BeginRequest(ShardMessageType::SHUTDOWN).EndFrame();
+}
+
+void ShardClient::Flush() {
+    connection_->Flush();
+}
+
+vector<string> ShardClient::ReceiveAddDocument() {
+    FrameReader response = ReceiveResponse(ShardMessageType::ADD_DOCUMENT);
+    return ReadStrings(response);
+}
+
+vector<string> ShardClient::ReceiveRemoveDocument() {
+    FrameReader response = ReceiveResponse(ShardMessageType::REMOVE_DOCUMENT);
+    return ReadStrings(response);
+}
+
+vector<Document> ShardClient::ReceiveDocuments() {
+    FrameReader response = ReceiveResponse(ShardMessageType::FIND_TOP_DOCUMENTS);
+    vector<Document> documents(response.Read<uint32_t>());
+    for (Document& document : documents) {
+        document.id = response.Read<int32_t>();
+        document.relevance = response.Read<double>();
+        document.rating = response.Read<int32_t>();
+    }
+    return documents;
+}
+
+tuple<vector<string>, DocumentStatus> ShardClient::ReceiveMatch() {
+    FrameReader response = ReceiveResponse(ShardMessageType::MATCH_DOCUMENT);
+    vector<string> words = ReadStrings(response);
+    return { move(words), ReadStatus(response) };
+}
+
+void ShardClient::ReceiveShutdown() {
+    ReceiveResponse(ShardMessageType::SHUTDOWN);
+}
+
+FrameWriter& ShardClient::BeginRequest(ShardMessageType type) {
+    FrameWriter& writer = connection_->GetWriter();
+    writer.BeginFrame(next_request_id_++, type);
+    return writer;
+}
+
+FrameReader ShardClient::ReceiveResponse(ShardMessageType type) {
+    FrameHeader header;
+    FrameReader response;
+    if (!connection_->ReadFrame(header, response)) {
+        throw runtime_error("The shard closed the connection."s);
+    }
+    if (header.request_id != next_response_id_++) {
+        throw runtime_error("The shard response does not match the request order."s);
+    }
+    if (header.type == ShardMessageType::ERROR) {
+        const ShardErrorKind kind = response.Read<ShardErrorKind>();
+        const string message(response.ReadString());
+        if (kind == ShardErrorKind::INVALID_ARGUMENT) {
+            throw invalid_argument(message);
+        } else if (kind == ShardErrorKind::OUT_OF_RANGE) {
+            throw out_of_range(message);
+        }
+        throw runtime_error(message);
+    }
+    if (header.type != type) {
+        throw runtime_error("The shard response does not match the request type."s);
+    }
+    return response;
+}
+
+ShardCoordinator::ShardCoordinator(const vector<string>& socket_paths) {
+    if (socket_paths.empty()) {
+        throw invalid_argument("At least one shard is required."s);
+    }
+    for (const string& socket_path : socket_paths) {
+        shards_.push_back(make_unique<ShardClient>(socket_path));
+    }
+}
+
+void ShardCoordinator::AddDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) {
+    ShardClient& shard = *shards_[ShardedSearchServer::ComputeShardIndex(document_id, shards_.size())];
+    shard.SendAddDocument(document_id, document, status, ratings);
+    shard.Flush();
+    AddDocumentWords(shard.ReceiveAddDocument());
+}
+
+void ShardCoordinator::AddDocumentBatch(const vector<const DocumentToAdd*>& documents) {
+    vector<AddDocumentsError::Failure> failures;
+    // пока координатор пишет окно, Flush дочитывает уже пришедшие ответы в буфер соединения,
+    // а окно лишь ограничивает, сколько их там накопится
+    const size_t window_size = PIPELINE_DEPTH * shards_.size();
+    for (size_t window_begin = 0; window_begin < documents.size(); window_begin += window_size) {
+        const size_t window_end = min(documents.size(), window_begin + window_size);
+        for (size_t position = window_begin; position < window_end; ++position) {
+            const DocumentToAdd& document = *documents[position];
+            shards_[ShardedSearchServer::ComputeShardIndex(document.id, shards_.size())]->SendAddDocument(
+                document.id, document.text, document.status, document.ratings);
+        }
+        for (const auto& shard : shards_) {
+            shard->Flush();
+        }
+        // ответы каждого шарда приходят в порядке его запросов
+        for (size_t position = window_begin; position < window_end; ++position) {
+            const int document_id = documents[position]->id;
+            try {
+                AddDocumentWords(shards_[ShardedSearchServer::ComputeShardIndex(document_id, shards_.size())]->ReceiveAddDocument());
+            } catch (const invalid_argument& error) {
+                failures.push_back({ position, document_id, error.what() });
+            }
+        }
+    }
+    if (!failures.empty()) {
+        throw AddDocumentsError(move(failures));
+    }
+}
+
+void ShardCoordinator::RemoveDocument(int document_id) {
+    ShardClient& shard = *shards_[ShardedSearchServer::ComputeShardIndex(document_id, shards_.size())];
+    shard.SendRemoveDocument(document_id);
+    shard.Flush();
+    const vector<string> words = shard.ReceiveRemoveDocument();
+    statistics_.RemoveDocument(vector<string_view>(words.begin(), words.end()));
+}
+
+vector<Document> ShardCoordinator::FindTopDocuments(const string_view raw_query, DocumentStatus status, size_t max_result_count) {
+    return FindTopDocumentsBatch({ string(raw_query) }, status, max_result_count).front();
+}
+
+vector<vector<Document>> ShardCoordinator::FindTopDocumentsBatch(const vector<string>& raw_queries, DocumentStatus status,
+    size_t max_result_count) {
+    vector<vector<Document>> results(raw_queries.size());
+    vector<vector<Document>> shard_documents(shards_.size());
+    exception_ptr error;
+    for (size_t window_begin = 0; window_begin < raw_queries.size(); window_begin += PIPELINE_DEPTH) {
+        const size_t window_end = min(raw_queries.size(), window_begin + PIPELINE_DEPTH);
+        for (size_t query = window_begin; query < window_end; ++query) {
+            const vector<pair<string_view, uint32_t>> document_freqs = GetQueryDocumentFreqs(raw_queries[query]);
+            for (const auto& shard : shards_) {
+                SendFindTopDocuments(*shard, raw_queries[query], status, max_result_count, document_freqs);
+            }
+        }
+        for (const auto& shard : shards_) {
+            shard->Flush();
+        }
+        // ответы читаются все, даже после ошибки, иначе следующие ответы сместятся
+        for (size_t query = window_begin; query < window_end; ++query) {
+            for (size_t shard = 0; shard < shards_.size(); ++shard) {
+                try {
+                    shard_documents[shard] = shards_[shard]->ReceiveDocuments();
+                } catch (const invalid_argument&) {
+                    error = error ? error : current_exception();
+                    shard_documents[shard].clear();
+                } catch (const out_of_range&) {
+                    error = error ? error : current_exception();
+                    shard_documents[shard].clear();
+                }
+            }
+            results[query] = MergeTopDocuments(shard_documents, max_result_count, SearchServer::IsMoreRelevant);
+        }
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+    return results;
+}
+
+tuple<vector<string>, DocumentStatus> ShardCoordinator::MatchDocument(const string_view raw_query, int document_id) {
+    ShardClient& shard = *shards_[ShardedSearchServer::ComputeShardIndex(document_id, shards_.size())];
+    shard.SendMatchDocument(raw_query, document_id);
+    shard.Flush();
+    return shard.ReceiveMatch();
+}
+
+int ShardCoordinator::GetDocumentCount() const {
+    return statistics_.GetDocumentCount();
+}
+
+size_t ShardCoordinator::GetShardCount() const {
+    return shards_.size();
+}
+
+void ShardCoordinator::Shutdown() {
+    for (const auto& shard : shards_) {
+        shard->SendShutdown();
+        shard->Flush();
+    }
+    for (const auto& shard : shards_) {
+        shard->ReceiveShutdown();
+    }
+    shards_.clear();
+}
+
+void ShardCoordinator::SendFindTopDocuments(ShardClient& shard, const string_view raw_query, DocumentStatus status,
+    size_t max_result_count, const vector<pair<string_view, uint32_t>>& document_freqs) const {
+    shard.SendFindTopDocuments(raw_query, status, max_result_count, statistics_.GetDocumentCount(), document_freqs);
+}
+
+vector<pair<string_view, uint32_t>> ShardCoordinator::GetQueryDocumentFreqs(const string_view raw_query) const {
+    vector<pair<string_view, uint32_t>> document_freqs;
+    for (string_view word : SplitIntoWords(raw_query)) {
+        if (!word.empty() && (word.front() == '-' || word.front() == '+')) {
+            word.remove_prefix(1);
+        }
+        // слова, которых нет в корпусе, нет и в шардах: IDF для них не нужен
+        if (const uint32_t document_freq = statistics_.GetDocumentFreq(word); document_freq > 0) {
+            document_freqs.emplace_back(word, document_freq);
+        }
+    }
+    return document_freqs;
+}
+
+void ShardCoordinator::AddDocumentWords(const vector<string>& words) {
+    statistics_.AddDocument(vector<string_view>(words.begin(), words.end()));
+}
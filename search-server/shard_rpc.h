@@ -0,0 +1,107 @@
+#pragma once
+#include "corpus_statistics.h"
+#include "search_server.h"
+#include "shard_protocol.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Обслуживает запросы к search_server по сокету Unix socket_path: подключения принимаются по очереди,
+// запросы каждого выполняются в порядке поступления. Ответы на все запросы, уже пришедшие одним пакетом,
+// отправляются одной записью. Возвращает после запроса SHUTDOWN.
+// На время работы IDF сервера вычисляется по статистике корпуса, которую присылает координатор с каждым поиском
+void ServeShard(SearchServer& search_server, const std::string& socket_path);
+
+// Клиент процесса шарда. Запросы Send* копятся и уходят одной записью при Flush, не дожидаясь ответов;
+// ответы читаются Receive* в том же порядке, в каком отправлены запросы. Ошибку шарда Receive* бросает
+// как invalid_argument, out_of_range или runtime_error. Клиент нельзя использовать из нескольких потоков
+class ShardClient {
+public:
+    static constexpr std::chrono::milliseconds CONNECT_TIMEOUT{ 5'000 };
+
+    explicit ShardClient(const std::string& socket_path);
+
+    void SendAddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void SendRemoveDocument(int document_id);
+    // document_count и document_freqs - статистика корпуса для слов запроса
+    void SendFindTopDocuments(const std::string_view raw_query, DocumentStatus status, size_t max_result_count,
+        int document_count, const std::vector<std::pair<std::string_view, uint32_t>>& document_freqs);
+    void SendMatchDocument(const std::string_view raw_query, int document_id);
+    void SendShutdown();
+    void Flush();
+
+    // Ответы на добавление и удаление - различные слова документа без стоп-слов
+    std::vector<std::string> ReceiveAddDocument();
+    std::vector<std::string> ReceiveRemoveDocument();
+    std::vector<Document> ReceiveDocuments();
+    std::tuple<std::vector<std::string>, DocumentStatus> ReceiveMatch();
+    void ReceiveShutdown();
+
+private:
+    std::unique_ptr<SocketConnection> connection_;
+    uint32_t next_request_id_ = 0;
+    uint32_t next_response_id_ = 0;
+
+    FrameWriter& BeginRequest(ShardMessageType type);
+    // Тело следующего ответа; проверяет его номер и вид
+    FrameReader ReceiveResponse(ShardMessageType type);
+};
+
+// Координатор процессов шардов: документы распределяются по шардам хешем id так же, как в ShardedSearchServer,
+// запрос рассылается всем шардам, а их лучшие документы сливаются. Координатор ведёт статистику корпуса
+// и передаёт её шардам вместе с запросом, поэтому выдача совпадает с выдачей одного SearchServer.
+// Пакетные операции отправляют запросы окнами по PIPELINE_DEPTH на шард, не дожидаясь ответов;
+// ответы, пришедшие во время записи, копятся в буфере соединения, поэтому их размер окно не ограничивает.
+// Координатор нельзя использовать из нескольких потоков
+class ShardCoordinator {
+public:
+    static constexpr size_t PIPELINE_DEPTH = 64;
+
+    // Подключается к шардам; каждый путь - сокет отдельного шарда
+    explicit ShardCoordinator(const std::vector<std::string>& socket_paths);
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Ошибки - как у SearchServer::AddDocuments
+    template <typename DocumentRange>
+    void AddDocuments(const DocumentRange& documents);
+    void RemoveDocument(int document_id);
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT);
+    // Результат i - для raw_queries[i]. Ошибка любого запроса пробрасывается после получения всех ответов
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries,
+        DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT);
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id);
+
+    int GetDocumentCount() const;
+    size_t GetShardCount() const;
+    // Останавливает все шарды; после этого координатор непригоден
+    void Shutdown();
+
+private:
+    std::vector<std::unique_ptr<ShardClient>> shards_;
+    CorpusStatistics statistics_;
+
+    void AddDocumentBatch(const std::vector<const DocumentToAdd*>& documents);
+    void SendFindTopDocuments(ShardClient& shard, const std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count, const std::vector<std::pair<std::string_view, uint32_t>>& document_freqs) const;
+    // Частоты в корпусе слов запроса без знаков минус и плюс
+    std::vector<std::pair<std::string_view, uint32_t>> GetQueryDocumentFreqs(const std::string_view raw_query) const;
+    void AddDocumentWords(const std::vector<std::string>& words);
+};
+
+template <typename DocumentRange>
+void ShardCoordinator::AddDocuments(const DocumentRange& documents) {
+    std::vector<const DocumentToAdd*> document_pointers;
+    for (const DocumentToAdd& document : documents) {
+        document_pointers.push_back(&document);
+    }
+    AddDocumentBatch(document_pointers);
+}
@@ -0,0 +1,173 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#define SEARCH_SERVER_HAS_THREAD_AFFINITY
+#endif
+
+using namespace std;
+
+void ShardedSearchServer::AddDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) {
+    const size_t shard = GetShardIndex(document_id);
+    // изменение выполняет поток шарда, чтобы новые списки документов выделялись рядом с его ядром
+    workers_[shard]->Submit([&] {
+        shards_[shard]->AddDocument(document_id, document, status, ratings);
+    }).get();
+    statistics_->AddDocument(GetDocumentWords(*shards_[shard], document_id));
+}
+
+void ShardedSearchServer::AddDocumentBatch(const vector<const DocumentToAdd*>& documents) {
+    vector<vector<size_t>> shard_positions(shards_.size());
+    for (size_t position = 0; position < documents.size(); ++position) {
+        shard_positions[GetShardIndex(documents[position]->id)].push_back(position);
+    }
+    const vector<vector<AddDocumentsError::Failure>> shard_failures = Scatter([&](size_t shard) {
+        vector<reference_wrapper<const DocumentToAdd>> shard_documents;
+        shard_documents.reserve(shard_positions[shard].size());
+        for (const size_t position : shard_positions[shard]) {
+            shard_documents.push_back(cref(*documents[position]));
+        }
+        vector<AddDocumentsError::Failure> failures;
+        try {
+            shards_[shard]->AddDocuments(shard_documents);
+        } catch (const AddDocumentsError& error) {
+            failures = error.GetFailures();
+        }
+        return failures;
+    });
+
+    // статистика не потокобезопасна и обновляется после того, как все шарды закончили
+    vector<AddDocumentsError::Failure> failures;
+    vector<bool> is_failed(documents.size(), false);
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        for (AddDocumentsError::Failure failure : shard_failures[shard]) {
+            failure.position = shard_positions[shard][failure.position];
+            is_failed[failure.position] = true;
+            failures.push_back(move(failure));
+        }
+    }
+    for (size_t position = 0; position < documents.size(); ++position) {
+        if (!is_failed[position]) {
+            const int document_id = documents[position]->id;
+            statistics_->AddDocument(GetDocumentWords(*shards_[GetShardIndex(document_id)], document_id));
+        }
+    }
+    if (!failures.empty()) {
+        sort(failures.begin(), failures.end(), [](const AddDocumentsError::Failure& lhs, const AddDocumentsError::Failure& rhs) {
+            return lhs.position < rhs.position;
+        });
+        throw AddDocumentsError(move(failures));
+    }
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    const size_t shard = GetShardIndex(document_id);
+    // строки слов остаются в словаре шарда и после удаления документа
+    const vector<string_view> words = GetDocumentWords(*shards_[shard], document_id);
+    workers_[shard]->Submit([&] {
+        shards_[shard]->RemoveDocument(document_id);
+    }).get();
+    statistics_->RemoveDocument(words);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view raw_query, DocumentStatus status,
+    size_t max_result_count) const {
+    return MergeTopDocuments(Scatter([&](size_t shard) {
+        return shards_[shard]->FindTopDocuments(raw_query, status, max_result_count);
+    }), max_result_count, SearchServer::IsMoreRelevant);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+SearchServer::words_and_status_document ShardedSearchServer::MatchDocument(const string_view raw_query, int document_id) const {
+    return shards_[GetShardIndex(document_id)]->MatchDocument(raw_query, document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    return statistics_->GetDocumentCount();
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    return ComputeShardIndex(document_id, shards_.size());
+}
+
+size_t ShardedSearchServer::ComputeShardIndex(int document_id, size_t shard_count) {
+    // фибоначчиево хеширование: id с общим шагом не собираются в одном шарде
+    const uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(document_id)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>((hash >> 32) % shard_count);
+}
+
+const SearchServer& ShardedSearchServer::GetShard(size_t shard) const {
+    return *shards_.at(shard);
+}
+
+vector<string_view> ShardedSearchServer::GetDocumentWords(const SearchServer& shard, int document_id) {
+    vector<string_view> words;
+    for (const auto& [word, freq] : shard.GetWordFrequencies(document_id)) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+ShardedSearchServer::ShardWorker::ShardWorker(size_t cpu)
+    : thread_([this] {
+        Run();
+    }) {
+#ifdef SEARCH_SERVER_HAS_THREAD_AFFINITY
+    // ядро выбирается среди разрешённых процессу; если закрепить не удалось, поток просто работает без привязки
+    cpu_set_t allowed_cpus;
+    CPU_ZERO(&allowed_cpus);
+    if (sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus) != 0 || CPU_COUNT(&allowed_cpus) == 0) {
+        return;
+    }
+    size_t cpu_number = cpu % static_cast<size_t>(CPU_COUNT(&allowed_cpus));
+    for (int candidate = 0; candidate < CPU_SETSIZE; ++candidate) {
+        if (CPU_ISSET(candidate, &allowed_cpus) && cpu_number-- == 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(candidate, &cpus);
+            pthread_setaffinity_np(thread_.native_handle(), sizeof(cpus), &cpus);
+            return;
+        }
+    }
+#endif
+}
+
+ShardedSearchServer::ShardWorker::~ShardWorker() {
+    {
+        lock_guard lock(mutex_);
+        is_stopping_ = true;
+    }
+    has_tasks_.notify_one();
+    thread_.join();
+}
+
+void ShardedSearchServer::ShardWorker::Run() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock lock(mutex_);
+            has_tasks_.wait(lock, [this] {
+                return is_stopping_ || !tasks_.empty();
+            });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
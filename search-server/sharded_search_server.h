@@ -0,0 +1,161 @@
+#pragma once
+#include "corpus_statistics.h"
+#include "search_server.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// SearchServer, разделённый на независимые шарды по хешу id документа. У каждого шарда свой поток,
+// закреплённый за отдельным ядром, где система это позволяет; шард создаётся в этом потоке, чтобы его память
+// выделялась рядом с ядром. Запрос рассылается всем шардам, их лучшие документы сливаются.
+// IDF вычисляется по общей статистике корпуса, поэтому выдача совпадает с выдачей одного SearchServer
+// с теми же документами. Поиск можно вести из нескольких потоков, но не одновременно с изменениями
+class ShardedSearchServer {
+public:
+    // shard_count == 0 - по шарду на ядро. Остальные аргументы передаются конструктору SearchServer каждого шарда
+    template <typename... Args>
+    explicit ShardedSearchServer(size_t shard_count, const Args&... args);
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Документы раскладываются по шардам, и шарды добавляют свои одновременно.
+    // Ошибки - как у SearchServer::AddDocuments, позиции в AddDocumentsError отсчитываются от начала documents
+    template <typename DocumentRange>
+    void AddDocuments(const DocumentRange& documents);
+    void RemoveDocument(int document_id);
+
+    // Предикат вызывается из потоков шардов одновременно
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status,
+        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+    // Выполняется шардом документа в вызывающем потоке
+    SearchServer::words_and_status_document MatchDocument(const std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+    size_t GetShardCount() const;
+    // Номер шарда, которому принадлежит документ с этим id
+    size_t GetShardIndex(int document_id) const;
+    static size_t ComputeShardIndex(int document_id, size_t shard_count);
+    const SearchServer& GetShard(size_t shard) const;
+
+private:
+    // Поток шарда: выполняет задачи по очереди
+    class ShardWorker {
+    public:
+        // cpu - порядковый номер ядра среди доступных процессу
+        explicit ShardWorker(size_t cpu);
+        ~ShardWorker();
+
+        template <typename Function>
+        std::future<std::invoke_result_t<Function>> Submit(Function function);
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable has_tasks_;
+        std::deque<std::function<void()>> tasks_;
+        bool is_stopping_ = false;
+        std::thread thread_;
+
+        void Run();
+    };
+
+    std::shared_ptr<CorpusStatistics> statistics_;
+    std::vector<std::unique_ptr<SearchServer>> shards_;
+    // объявлены после шардов, поэтому потоки останавливаются раньше разрушения шардов
+    std::vector<std::unique_ptr<ShardWorker>> workers_;
+
+    // Выполняет function(shard) в потоке каждого шарда и возвращает результаты по номерам шардов.
+    // Дожидается всех шардов и только потом пробрасывает первое исключение
+    template <typename Function>
+    auto Scatter(Function function) const;
+    void AddDocumentBatch(const std::vector<const DocumentToAdd*>& documents);
+    // Различные слова документа без стоп-слов; строки указывают в словарь шарда
+    static std::vector<std::string_view> GetDocumentWords(const SearchServer& shard, int document_id);
+};
+
+template <typename... Args>
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, const Args&... args)
+    : statistics_(std::make_shared<CorpusStatistics>()) {
+    if (shard_count == 0) {
+        shard_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    shards_.resize(shard_count);
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+        workers_.push_back(std::make_unique<ShardWorker>(shard));
+    }
+    Scatter([&](size_t shard) {
+        shards_[shard] = std::make_unique<SearchServer>(args...);
+        shards_[shard]->SetCorpusStatistics(statistics_);
+        return shard;
+    });
+}
+
+template <typename DocumentRange>
+void ShardedSearchServer::AddDocuments(const DocumentRange& documents) {
+    std::vector<const DocumentToAdd*> document_pointers;
+    for (const DocumentToAdd& document : documents) {
+        document_pointers.push_back(&document);
+    }
+    AddDocumentBatch(document_pointers);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view raw_query,
+    DocumentPredicate document_predicate, size_t max_result_count) const {
+    return MergeTopDocuments(Scatter([&](size_t shard) {
+        return shards_[shard]->FindTopDocuments(raw_query, document_predicate, max_result_count);
+    }), max_result_count, SearchServer::IsMoreRelevant);
+}
+
+template <typename Function>
+auto ShardedSearchServer::Scatter(Function function) const {
+    using Result = std::invoke_result_t<Function, size_t>;
+    std::vector<std::future<Result>> futures;
+    futures.reserve(workers_.size());
+    for (size_t shard = 0; shard < workers_.size(); ++shard) {
+        futures.push_back(workers_[shard]->Submit([&function, shard] {
+            return function(shard);
+        }));
+    }
+    // задачи ссылаются на function и аргументы вызывающего, поэтому выходить раньше всех шардов нельзя
+    for (auto& future : futures) {
+        future.wait();
+    }
+    std::vector<Result> results;
+    results.reserve(futures.size());
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+template <typename Function>
+std::future<std::invoke_result_t<Function>> ShardedSearchServer::ShardWorker::Submit(Function function) {
+    // packaged_task нельзя копировать, а очередь хранит копируемые std::function
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    auto future = task->get_future();
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.emplace_back([task] {
+            (*task)();
+        });
+    }
+    has_tasks_.notify_one();
+    return future;
+}
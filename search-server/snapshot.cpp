@@ -0,0 +1,48 @@
+#include "snapshot.h"
+
+using namespace std;
+
+SnapshotWriter::SnapshotWriter(ostream& output)
+    : output_(output) {
+}
+
+void SnapshotWriter::WriteString(string_view text) {
+    Write<uint64_t>(text.size());
+    WriteBytes(text.data(), text.size());
+}
+
+void SnapshotWriter::WriteBytes(const void* data, size_t size) {
+    output_.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+    position_ += size;
+}
+
+void SnapshotWriter::Align() {
+    static const char padding[ALIGNMENT] = {};
+    WriteBytes(padding, (ALIGNMENT - position_ % ALIGNMENT) % ALIGNMENT);
+}
+
+SnapshotReader::SnapshotReader(const char* data, size_t size)
+    : data_(data)
+    , size_(size) {
+}
+
+string_view SnapshotReader::ReadString() {
+    const uint64_t size = Read<uint64_t>();
+    if (size > size_ - position_) {
+        throw invalid_argument("The snapshot is truncated or corrupted."s);
+    }
+    return { ReadBytes(static_cast<size_t>(size)), static_cast<size_t>(size) };
+}
+
+const char* SnapshotReader::ReadBytes(size_t size) {
+    if (size > size_ - position_) {
+        throw invalid_argument("The snapshot is truncated or corrupted."s);
+    }
+    const char* bytes = data_ + position_;
+    position_ += size;
+    return bytes;
+}
+
+void SnapshotReader::Align() {
+    ReadBytes((SnapshotWriter::ALIGNMENT - position_ % SnapshotWriter::ALIGNMENT) % SnapshotWriter::ALIGNMENT);
+}
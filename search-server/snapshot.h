@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+using namespace std::string_literals;
+
+// Запись снимка индекса. Значения пишутся в порядке байтов машины, массивы выравниваются на 8 байт,
+// чтобы при загрузке их можно было читать прямо из отображённого файла
+class SnapshotWriter {
+public:
+    static constexpr size_t ALIGNMENT = 8;
+
+    explicit SnapshotWriter(std::ostream& output);
+
+    template <typename Value>
+    void Write(const Value& value);
+    void WriteString(std::string_view text);
+    // Количество элементов, затем выровненные элементы
+    template <typename Value>
+    void WriteArray(const Value* values, size_t count);
+
+private:
+    std::ostream& output_;
+    size_t position_ = 0;
+
+    void WriteBytes(const void* data, size_t size);
+    void Align();
+};
+
+// Чтение снимка из памяти. Выход за границы данных бросает std::invalid_argument
+class SnapshotReader {
+public:
+    // data должна быть выровнена на SnapshotWriter::ALIGNMENT
+    SnapshotReader(const char* data, size_t size);
+
+    template <typename Value>
+    Value Read();
+    // Строка указывает в данные снимка
+    std::string_view ReadString();
+    // Указатель на элементы внутри данных снимка, count - их количество
+    template <typename Value>
+    const Value* ReadArray(size_t& count);
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t position_ = 0;
+
+    const char* ReadBytes(size_t size);
+    void Align();
+};
+
+template <typename Value>
+void SnapshotWriter::Write(const Value& value) {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    WriteBytes(&value, sizeof(value));
+}
+
+template <typename Value>
+void SnapshotWriter::WriteArray(const Value* values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<Value> && alignof(Value) <= ALIGNMENT);
+    Write<uint64_t>(count);
+    Align();
+    WriteBytes(values, count * sizeof(Value));
+}
+
+template <typename Value>
+Value SnapshotReader::Read() {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    Value value;
+    std::memcpy(&value, ReadBytes(sizeof(value)), sizeof(value));
+    return value;
+}
+
+template <typename Value>
+const Value* SnapshotReader::ReadArray(size_t& count) {
+    static_assert(std::is_trivially_copyable_v<Value> && alignof(Value) <= SnapshotWriter::ALIGNMENT);
+    const uint64_t array_size = Read<uint64_t>();
+    Align();
+    if (array_size > (size_ - position_) / sizeof(Value)) {
+        throw std::invalid_argument("The snapshot is truncated or corrupted."s);
+    }
+    count = static_cast<size_t>(array_size);
+    return reinterpret_cast<const Value*>(ReadBytes(count * sizeof(Value)));
+}
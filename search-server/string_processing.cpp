@@ -1,16 +1,92 @@
 #include "string_processing.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SEARCH_SERVER_HAS_SSE2
+#endif
+
 using namespace std;
 
+namespace {
+    //   ( 0-31)     
+    bool IsControlCharacter(char c) {
+        return static_cast<unsigned char>(c) < ' ';
+    }
+
+#ifdef SEARCH_SERVER_HAS_SSE2
+    constexpr size_t CHUNK_SIZE = 16;
+
+    //    :    31       31
+    uint32_t GetControlMask(__m128i chunk) {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, _mm_set1_epi8(' ' - 1)), chunk)));
+    }
+#endif
+} // namespace
+
+bool SplitIntoWords(string_view text, vector<string_view>& words) {
+    words.clear();
+    const char* const data = text.data();
+    const size_t size = text.size();
+    size_t position = 0;
+    size_t word_begin = 0;
+    bool in_word = false;
+    bool has_control_characters = false;
+#ifdef SEARCH_SERVER_HAS_SSE2
+    const __m128i spaces = _mm_set1_epi8(' ');
+    for (; position + CHUNK_SIZE <= size; position += CHUNK_SIZE) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+        const uint32_t space_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces)));
+        has_control_characters |= GetControlMask(chunk) != 0;
+        //   - ,     ,   
+        uint32_t boundaries = (space_mask ^ (space_mask << 1 | (in_word ? 0u : 1u))) & 0xFFFF;
+        for (; boundaries != 0; boundaries &= boundaries - 1) {
+            const size_t boundary = position + static_cast<size_t>(__builtin_ctz(boundaries));
+            if (in_word) {
+                words.emplace_back(data + word_begin, boundary - word_begin);
+            } else {
+                word_begin = boundary;
+            }
+            in_word = !in_word;
+        }
+    }
+#endif
+    //        SSE2
+    for (; position < size; ++position) {
+        has_control_characters |= IsControlCharacter(data[position]);
+        if ((data[position] == ' ') == in_word) {
+            if (in_word) {
+                words.emplace_back(data + word_begin, position - word_begin);
+            } else {
+                word_begin = position;
+            }
+            in_word = !in_word;
+        }
+    }
+    if (in_word) {
+        words.emplace_back(data + word_begin, size - word_begin);
+    }
+    return !has_control_characters;
+}
+
 vector<string_view> SplitIntoWords(string_view text) {
-    vector<string_view> result;
-    text.remove_prefix(min(text.find_first_not_of(" "), text.size())); //   
-    while (!text.empty()) {
-        size_t position_first_space = text.find(' ');
-        string_view tmp_substr = text.substr(0, position_first_space);
-        result.push_back(tmp_substr);
-        text.remove_prefix(tmp_substr.size());
-        text.remove_prefix(min(text.find_first_not_of(" "), text.size())); //   
+    vector<string_view> words;
+    SplitIntoWords(text, words);
+    return words;
+}
+
+bool HasControlCharacters(string_view text) {
+    size_t position = 0;
+#ifdef SEARCH_SERVER_HAS_SSE2
+    for (; position + CHUNK_SIZE <= text.size(); position += CHUNK_SIZE) {
+        if (GetControlMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + position))) != 0) {
+            return true;
+        }
+    }
+#endif
+    for (; position < text.size(); ++position) {
+        if (IsControlCharacter(text[position])) {
+            return true;
+        }
     }
-    return result;
-}
\ No newline at end of file
+    return false;
+}
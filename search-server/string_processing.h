@@ -6,6 +6,11 @@
 #include <functional>
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
+// Разбивает текст на слова за один проход, проверяя заодно символы. Слова записываются в words,
+// память которого переиспользуется между вызовами. Возвращает false, если в тексте есть
+// управляющие символы (коды 0-31); слова при этом всё равно выделяются
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+bool HasControlCharacters(std::string_view text);
 
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
@@ -0,0 +1,72 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+using namespace std;
+
+TermDictionary::TermDictionary(const TermDictionary& other) {
+    // строки копируются в собственную арену, чтобы не ссылаться на чужую
+    for (const string_view term : other.terms_) {
+        Intern(term);
+    }
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        TermDictionary copy(other);
+        *this = move(copy);
+    }
+    return *this;
+}
+
+TermId TermDictionary::Intern(string_view word) {
+    if (const auto it = term_ids_.find(word); it != term_ids_.end()) {
+        return it->second;
+    }
+    assert(terms_.size() < NO_TERM);
+    const TermId term = static_cast<TermId>(terms_.size());
+    const string_view stored_word = Store(word);
+    terms_.push_back(stored_word);
+    term_ids_.emplace(stored_word, term);
+    return term;
+}
+
+TermId TermDictionary::Find(string_view word) const {
+    const auto it = term_ids_.find(word);
+    return it == term_ids_.end() ? NO_TERM : it->second;
+}
+
+string_view TermDictionary::GetTerm(TermId term) const {
+    return terms_[term];
+}
+
+size_t TermDictionary::GetTermCount() const {
+    return terms_.size();
+}
+
+size_t TermDictionary::GetArenaSize() const {
+    return arena_size_;
+}
+
+string_view TermDictionary::Store(string_view word) {
+    if (word.size() > block_free_) {
+        if (word.size() > BLOCK_SIZE / 4) {
+            // длинное слово получает отдельный блок, чтобы не терять остаток текущего
+            blocks_.push_back(make_unique<char[]>(word.size()));
+            arena_size_ += word.size();
+            copy(word.begin(), word.end(), blocks_.back().get());
+            return { blocks_.back().get(), word.size() };
+        }
+        blocks_.push_back(make_unique<char[]>(BLOCK_SIZE));
+        arena_size_ += BLOCK_SIZE;
+        block_position_ = blocks_.back().get();
+        block_free_ = BLOCK_SIZE;
+    }
+    char* const stored_word = block_position_;
+    copy(word.begin(), word.end(), stored_word);
+    block_position_ += word.size();
+    block_free_ -= word.size();
+    return { stored_word, word.size() };
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using TermId = uint32_t;
+
+// Словарь слов индекса: каждое слово хранится один раз в арене и получает 32-битный номер.
+// Арена выделяется блоками и никогда не перемещает строки, поэтому выданные string_view
+// остаются действительными всё время жизни словаря
+class TermDictionary {
+public:
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    TermDictionary() = default;
+    TermDictionary(const TermDictionary& other);
+    TermDictionary& operator=(const TermDictionary& other);
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    // Номер слова; слово добавляется, если его ещё нет
+    TermId Intern(std::string_view word);
+    // Номер слова или NO_TERM
+    TermId Find(std::string_view word) const;
+    std::string_view GetTerm(TermId term) const;
+    size_t GetTermCount() const;
+    // Байты, занятые ареной
+    size_t GetArenaSize() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t arena_size_ = 0;
+    size_t block_free_ = 0;
+    char* block_position_ = nullptr;
+    std::vector<std::string_view> terms_;
+    std::unordered_map<std::string_view, TermId> term_ids_;
+
+    std::string_view Store(std::string_view word);
+};
@@ -1,17 +1,138 @@
 #include "tests.h"
 
+#include <algorithm>
+#include <atomic>
 #include <execution>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <random>
+#include <sstream>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <new>
+#include <numeric>
 #include <functional>
 
 using namespace std;
 
+namespace {
+    atomic<size_t> allocation_count = 0;
+
+    void* AllocateCounted(size_t size) noexcept {
+        ++allocation_count;
+        return malloc(size == 0 ? 1 : size);
+    }
+
+    void* AllocateCounted(size_t size, align_val_t alignment) noexcept {
+        ++allocation_count;
+        // aligned_alloc требует размер, кратный выравниванию
+        const size_t align = static_cast<size_t>(alignment);
+        return aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align);
+    }
+
+    void* AllocateOrThrow(void* memory) {
+        if (memory == nullptr) {
+            throw bad_alloc();
+        }
+        return memory;
+    }
+} // namespace
+
+// Подсчёт выделений памяти во всей программе тестов и замеров. Заменены все формы new и delete,
+// чтобы любая пара выделения и освобождения проходила через malloc и free
+void* operator new(size_t size) {
+    return AllocateOrThrow(AllocateCounted(size));
+}
+
+void* operator new[](size_t size) {
+    return AllocateOrThrow(AllocateCounted(size));
+}
+
+// временные буферы stable_sort выделяются этой версией
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    return AllocateCounted(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return AllocateCounted(size);
+}
+
+void* operator new(size_t size, align_val_t alignment) {
+    return AllocateOrThrow(AllocateCounted(size, alignment));
+}
+
+void* operator new[](size_t size, align_val_t alignment) {
+    return AllocateOrThrow(AllocateCounted(size, alignment));
+}
+
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return AllocateCounted(size, alignment);
+}
+
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return AllocateCounted(size, alignment);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, const nothrow_t&) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, const nothrow_t&) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t, align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, align_val_t, const nothrow_t&) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, align_val_t, const nothrow_t&) noexcept {
+    free(memory);
+}
+
 namespace test {
+    size_t GetAllocationCount() {
+        return allocation_count;
+    }
+
     bool IsEqualDouble(double lhs, double rhs, double epsilon = 1e-6) {
         return abs(lhs - rhs) <= epsilon ? true : false;
     }
@@ -108,6 +229,11 @@ namespace test {
         }{ // последовательная версия
             const vector<Document> documents = search_server.FindTopDocuments(execution::seq, "curly nasty cat"s, DocumentStatus::BANNED);
             assert(documents.empty());
+        }{ // ограничение количества документов в выдаче
+            const vector<Document> documents = search_server.FindTopDocuments("curly nasty cat"s, DocumentStatus::ACTUAL, 2);
+            assert(documents.size() == 2);
+            assert(documents.at(0).id == 2 && documents.at(1).id == 4);
+            assert(search_server.FindTopDocuments(execution::par, "curly nasty cat"s, DocumentStatus::ACTUAL, 0).empty());
         }{ // параллельная версия
             function<bool(int, DocumentStatus, int)> predicate = [](int document_id, DocumentStatus status, int rating) {
                 return document_id % 2 == 0;
@@ -125,4 +251,1332 @@ namespace test {
         }
         cerr << ">>> TestFind has been passed"sv << endl;
     }
+
+    void TestRemoveDocument() {
+        SearchServer search_server("and with"s);
+        search_server.AddDocument(1, "white cat and yellow hat"s, DocumentStatus::ACTUAL, { 1 });
+        search_server.AddDocument(2, "curly cat curly tail"s, DocumentStatus::ACTUAL, { 2 });
+        search_server.AddDocument(3, "nasty dog with big eyes"s, DocumentStatus::ACTUAL, { 3 });
+
+        // слова удалённого документа остаются в словаре сервера
+        search_server.RemoveDocument(1);
+        assert(search_server.GetDocumentCount() == 2);
+        assert(search_server.GetWordFrequencies(1).empty());
+        {
+            const map<string_view, double> word_frequencies = search_server.GetWordFrequencies(2);
+            assert(word_frequencies.size() == 3);
+            assert(word_frequencies.at("curly"sv) == 0.5 && word_frequencies.at("cat"sv) == 0.25);
+        }
+        {
+            const vector<Document> documents = search_server.FindTopDocuments("cat hat"s);
+            assert(documents.size() == 1);
+            assert(documents.at(0).id == 2);
+        }
+        search_server.RemoveDocument(execution::par, 2);
+        assert(search_server.FindTopDocuments("cat"s).empty());
+        {
+            const string query = "cat dog"s;
+            const auto [words, status] = search_server.MatchDocument(query, 3);
+            assert(words.size() == 1 && words.at(0) == "dog"s);
+        }
+        // повторное добавление документа с тем же id
+        search_server.AddDocument(1, "black cat"s, DocumentStatus::ACTUAL, { 4 });
+        search_server.AddDocument(0, "grey cat"s, DocumentStatus::ACTUAL, { 5 });
+        {
+            const vector<Document> documents = search_server.FindTopDocuments("cat"s);
+            assert(documents.size() == 2);
+            assert(documents.at(0).id == 0 && documents.at(1).id == 1);
+        }
+        cerr << ">>> TestRemoveDocument has been passed"sv << endl;
+    }
+
+    void TestConcurrentMap() {
+        constexpr int kKeyCount = 10'000;
+        constexpr int kRepeatCount = 10;
+        ConcurrentMap<int, int> concurrent_map(16);
+        vector<int> keys(kKeyCount * kRepeatCount);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keys[i] = static_cast<int>(i % kKeyCount) * 3;
+        }
+        for_each(execution::par, keys.begin(), keys.end(), [&concurrent_map](int key) {
+            concurrent_map[key] += 1;
+        });
+        // удаление вперемешку со вставкой: нечётные ключи удаляются, новые отрицательные добавляются
+        for_each(execution::par, keys.begin(), keys.begin() + kKeyCount, [&concurrent_map](int key) {
+            if (key % 2 != 0) {
+                concurrent_map.Erase(key);
+            }
+            concurrent_map[-key - 1] += 2;
+        });
+        int total = 0;
+        concurrent_map.ForEach([&total]([[maybe_unused]] int key, int& value) {
+            assert(key < 0 ? value == 2 : value == kRepeatCount);
+            total += value;
+        });
+        assert(total == kKeyCount / 2 * kRepeatCount + kKeyCount * 2);
+
+        const map<int, int> ordinary_map = concurrent_map.BuildOrdinaryMap();
+        assert(ordinary_map.size() == kKeyCount / 2 + kKeyCount);
+        assert(ordinary_map.at(0) == kRepeatCount && ordinary_map.count(3) == 0);
+
+        const vector<pair<int, int>> extracted = concurrent_map.Extract();
+        assert(extracted.size() == ordinary_map.size());
+        assert(concurrent_map.BuildOrdinaryMap().empty());
+        cerr << ">>> TestConcurrentMap has been passed"sv << endl;
+    }
+
+    void TestQueryCache() {
+        SearchServer search_server("and with"s);
+        search_server.AddDocument(1, "white cat and yellow hat"s, DocumentStatus::ACTUAL, { 1 });
+        search_server.AddDocument(2, "curly cat curly tail"s, DocumentStatus::ACTUAL, { 2 });
+        search_server.AddDocument(3, "nasty dog with big eyes"s, DocumentStatus::BANNED, { 3 });
+        search_server.SetQueryCacheMemoryLimit(1 << 20);
+
+        const vector<Document> expected = search_server.FindTopDocuments("curly cat -dog"s);
+        // другой порядок и повтор слов дают тот же нормализованный запрос
+        const vector<Document> cached = search_server.FindTopDocuments(execution::par, "-dog cat curly cat"s);
+        assert(cached.size() == expected.size() && cached.at(0).id == expected.at(0).id);
+        assert(search_server.GetQueryCacheStats().hits == 1);
+        assert(search_server.GetQueryCacheStats().misses == 1);
+        // статус и количество документов входят в ключ
+        assert(search_server.FindTopDocuments("curly cat -dog"s, DocumentStatus::BANNED).empty());
+        assert(search_server.FindTopDocuments("curly cat -dog"s, DocumentStatus::ACTUAL, 1).size() == 1);
+        assert(search_server.GetQueryCacheStats().misses == 3);
+
+        // документ со словом запроса удаляет записи сразу
+        search_server.AddDocument(4, "dog and cat"s, DocumentStatus::ACTUAL, { 4 });
+        assert(search_server.GetQueryCacheStats().entry_count == 0);
+        assert(search_server.GetQueryCacheStats().invalidations == 3);
+        search_server.FindTopDocuments("curly cat -dog"s);
+        // документ без слов запроса меняет IDF, запись устаревает при следующем обращении
+        search_server.AddDocument(5, "grey pigeon"s, DocumentStatus::ACTUAL, { 5 });
+        assert(search_server.GetQueryCacheStats().entry_count == 1);
+        const vector<Document> after_add = search_server.FindTopDocuments("curly cat -dog"s);
+        assert(search_server.GetQueryCacheStats().invalidations == 4);
+        search_server.SetQueryCacheMemoryLimit(0);
+        const vector<Document> uncached = search_server.FindTopDocuments("curly cat -dog"s);
+        assert(after_add.size() == uncached.size());
+        for (size_t i = 0; i < uncached.size(); ++i) {
+            assert(after_add.at(i).id == uncached.at(i).id);
+            assert(IsEqualDouble(after_add.at(i).relevance, uncached.at(i).relevance));
+        }
+
+        // маленький бюджет вытесняет давно использованные записи
+        search_server.SetQueryCacheMemoryLimit(1024);
+        for (const string& query : { "cat"s, "dog"s, "hat"s, "tail"s, "eyes"s, "pigeon"s }) {
+            search_server.FindTopDocuments(query);
+        }
+        [[maybe_unused]] const QueryCacheStats stats = search_server.GetQueryCacheStats();
+        assert(stats.evictions > 0 && stats.memory_usage <= 1024);
+
+        // с общей статистикой корпуса запись устаревает вместе с ней, а не с числом документов сервера
+        {
+            SearchServer shard(""s);
+            shard.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, { 1 });
+            shard.SetQueryCacheMemoryLimit(1 << 20);
+            const auto statistics = make_shared<CorpusStatistics>();
+            shard.SetCorpusStatistics(statistics);
+            statistics->SetDocumentFreqs(10, { { "cat"sv, 1 } });
+            assert(IsEqualDouble(shard.FindTopDocuments("cat"s).at(0).relevance, log(10.0)));
+            statistics->SetDocumentFreqs(100, { { "cat"sv, 1 } });
+            assert(IsEqualDouble(shard.FindTopDocuments("cat"s).at(0).relevance, log(100.0)));
+            assert(shard.GetQueryCacheStats().invalidations == 1);
+            shard.SetCorpusStatistics(nullptr);
+        }
+        cerr << ">>> TestQueryCache has been passed"sv << endl;
+    }
+
+    void TestProcessQueries() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 200, 5);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 2'000, 20);
+        SearchServer search_server(dictionary[0]);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const DocumentStatus status = i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+            search_server.AddDocument(static_cast<int>(i), documents[i], status, { static_cast<int>(i % 7) });
+        }
+        search_server.RemoveDocument(7);
+        vector<string> queries;
+        for (int i = 0; i < 300; ++i) {
+            queries.push_back(GenerateQuery(generator, dictionary, 4, 0.2));
+        }
+
+        const vector<vector<Document>> results = ProcessQueries(search_server, queries);
+        assert(results.size() == queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const vector<Document> expected = search_server.FindTopDocuments(queries[i]);
+            assert(results[i].size() == expected.size());
+            for (size_t j = 0; j < expected.size(); ++j) {
+                assert(results[i][j].id == expected[j].id);
+                assert(IsEqualDouble(results[i][j].relevance, expected[j].relevance));
+            }
+        }
+        {
+            const QueryResults joined = ProcessQueriesJoined(search_server, queries);
+            auto joined_document = joined.begin();
+            for ([[maybe_unused]] const Document& document : AllFindedDocuments(results)) {
+                assert(joined_document != joined.end() && joined_document->id == document.id);
+                ++joined_document;
+            }
+            assert(joined_document == joined.end());
+        }
+        const QueryResults banned = search_server.FindTopDocumentsBatch(queries, DocumentStatus::BANNED, 20);
+        assert(banned.GetQueryCount() == queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            assert(banned[i].size() == search_server.FindTopDocuments(queries[i], DocumentStatus::BANNED, 20).size());
+        }
+        cerr << ">>> TestProcessQueries has been passed"sv << endl;
+    }
+
+    void TestPostingListFormats() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 300, 5);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 3'000, 15);
+        SearchServer plain_server(""s, PostingListFormat::PLAIN);
+        SearchServer compressed_server(""s, PostingListFormat::COMPRESSED);
+        for (SearchServer* search_server : { &plain_server, &compressed_server }) {
+            for (size_t i = 0; i < documents.size(); ++i) {
+                search_server->AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, { static_cast<int>(i % 5) });
+            }
+            // длинный документ: число вхождений слова не помещается в один байт varint
+            string long_document;
+            for (int i = 0; i < 300; ++i) {
+                long_document += dictionary[0] + ' ';
+            }
+            search_server->AddDocument(5'000, long_document + dictionary[1], DocumentStatus::ACTUAL, { 1 });
+            // удалены почти все документы, поэтому разности номеров тоже занимают несколько байт
+            for (int i = 0; i < 3'000; ++i) {
+                if (i % 200 != 0) {
+                    search_server->RemoveDocument(i);
+                }
+            }
+        }
+        assert(compressed_server.GetPostingsMemoryUsage() < plain_server.GetPostingsMemoryUsage());
+        for (int i = 0; i < 200; ++i) {
+            const string query = GenerateQuery(generator, dictionary, 3, 0.1);
+            const vector<Document> expected = plain_server.FindTopDocuments(execution::par, query);
+            const vector<Document> found = compressed_server.FindTopDocuments(query);
+            assert(found.size() == expected.size());
+            for (size_t j = 0; j < expected.size(); ++j) {
+                assert(found[j].id == expected[j].id && found[j].relevance == expected[j].relevance);
+            }
+        }
+        const auto [words, status] = compressed_server.MatchDocument(dictionary[0], 5'000);
+        assert(words.size() == 1);
+        compressed_server.RemoveDocument(5'000);
+        for ([[maybe_unused]] const Document& document : compressed_server.FindTopDocuments(dictionary[0])) {
+            assert(document.id != 5'000);
+        }
+        cerr << ">>> TestPostingListFormats has been passed"sv << endl;
+    }
+
+    void TestSnapshot() {
+        using namespace test_policies;
+        const string path = (filesystem::temp_directory_path() / "search_server_test.snapshot"s).string();
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 200, 5);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 1'000, 10);
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            SearchServer search_server(dictionary[0] + ' ' + dictionary[1], format);
+            for (size_t i = 0; i < documents.size(); ++i) {
+                const DocumentStatus status = i % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+                search_server.AddDocument(static_cast<int>(i * 2), documents[i], status, { static_cast<int>(i % 11) });
+            }
+            search_server.RemoveDocument(10);
+            search_server.SaveSnapshot(path);
+
+            SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+            assert(loaded_server.GetDocumentCount() == search_server.GetDocumentCount());
+            assert(equal(loaded_server.begin(), loaded_server.end(), search_server.begin(), search_server.end()));
+            assert(loaded_server.GetWordFrequencies(4) == search_server.GetWordFrequencies(4));
+            for (int i = 0; i < 100; ++i) {
+                const string query = GenerateQuery(generator, dictionary, 3, 0.1);
+                const vector<Document> expected = search_server.FindTopDocuments(query, DocumentStatus::BANNED);
+                const vector<Document> found = loaded_server.FindTopDocuments(query, DocumentStatus::BANNED);
+                assert(found.size() == expected.size());
+                for (size_t j = 0; j < expected.size(); ++j) {
+                    assert(found[j].id == expected[j].id && found[j].relevance == expected[j].relevance);
+                }
+                assert(loaded_server.MatchDocument(query, 6) == search_server.MatchDocument(query, 6));
+            }
+            // изменение загруженного сервера копирует затронутые списки из файла
+            loaded_server.RemoveDocument(4);
+            loaded_server.AddDocument(4, dictionary[2], DocumentStatus::ACTUAL, { 1 });
+            const vector<Document> found = loaded_server.FindTopDocuments(dictionary[2]);
+            assert(!found.empty() && found.at(0).id == 4);
+
+            // снимок сохраняется поверх файла, из которого загружен сервер, а сервер продолжает его читать
+            loaded_server.SaveSnapshot(path);
+            const SearchServer reloaded_server = SearchServer::LoadSnapshot(path);
+            assert(reloaded_server.GetDocumentCount() == loaded_server.GetDocumentCount());
+            for (int i = 0; i < 20; ++i) {
+                const string query = GenerateQuery(generator, dictionary, 3, 0.1);
+                [[maybe_unused]] const vector<Document> expected = loaded_server.FindTopDocuments(query);
+                [[maybe_unused]] const vector<Document> reloaded_found = reloaded_server.FindTopDocuments(query);
+                assert(reloaded_found.size() == expected.size());
+                for (size_t j = 0; j < expected.size(); ++j) {
+                    assert(reloaded_found[j].id == expected[j].id && reloaded_found[j].relevance == expected[j].relevance);
+                }
+            }
+            assert(!filesystem::exists(path + ".tmp"s));
+        }
+        {
+            // пустой сервер со стоп-словами
+            SearchServer search_server("and in"s);
+            search_server.SaveSnapshot(path);
+            SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+            assert(loaded_server.GetDocumentCount() == 0 && loaded_server.FindTopDocuments("cat in"s).empty());
+            loaded_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, { 1 });
+            assert(loaded_server.FindTopDocuments("cat in"s).size() == 1);
+        }
+        {
+            // обрезанный снимок
+            SearchServer search_server(""s);
+            search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+            search_server.SaveSnapshot(path);
+            filesystem::resize_file(path, filesystem::file_size(path) - 1);
+            try {
+                SearchServer::LoadSnapshot(path);
+                assert(false);
+            } catch (const invalid_argument&) {
+            }
+        }
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            // снимок с одним испорченным байтом либо не загружается, либо загруженный сервер отвечает на запросы
+            SearchServer search_server("and"s, format);
+            search_server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+            search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 2 });
+            search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 3 });
+            search_server.RemoveDocument(2);
+            search_server.SaveSnapshot(path);
+            string snapshot;
+            {
+                ifstream input(path, ios::binary);
+                snapshot.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+            }
+            for (size_t position = 0; position < snapshot.size(); ++position) {
+                string corrupted = snapshot;
+                corrupted[position] ^= static_cast<char>(1 << (position % 8));
+                {
+                    ofstream output(path, ios::binary | ios::trunc);
+                    output.write(corrupted.data(), static_cast<streamsize>(corrupted.size()));
+                }
+                try {
+                    const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+                    for (const string& query : { "cat"s, "fluffy collar"s, "dog -eyes"s }) {
+                        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                            loaded_server.FindTopDocuments(query, status);
+                        }
+                    }
+                } catch (const invalid_argument&) {
+                }
+            }
+        }
+        filesystem::remove(path);
+        cerr << ">>> TestSnapshot has been passed"sv << endl;
+    }
+
+    void TestAddDocuments() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 500, 6);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 5'000, 12);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            documents.push_back({ static_cast<int>(i), texts[i], i % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+                { static_cast<int>(i % 9), 1 } });
+        }
+        const string invalid_text = "white\x12 cat"s;
+        documents.push_back({ 3, "duplicate in the batch"sv, DocumentStatus::ACTUAL, {} });
+        documents.push_back({ -1, "negative id"sv, DocumentStatus::ACTUAL, {} });
+        documents.push_back({ 100'000, invalid_text, DocumentStatus::ACTUAL, {} });
+        documents.push_back({ 100'001, "stop"sv, DocumentStatus::ACTUAL, {} });
+
+        SearchServer expected_server("stop"s);
+        expected_server.AddDocument(100'002, "already indexed"s, DocumentStatus::ACTUAL, { 1 });
+        for (const DocumentToAdd& document : documents) {
+            try {
+                expected_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            } catch (const invalid_argument&) {
+            }
+        }
+        documents.push_back({ 100'002, "already indexed"sv, DocumentStatus::ACTUAL, {} });
+
+        for (const bool parallel : { false, true }) {
+            SearchServer search_server("stop"s);
+            search_server.AddDocument(100'002, "already indexed"s, DocumentStatus::ACTUAL, { 1 });
+            try {
+                if (parallel) {
+                    search_server.AddDocuments(execution::par, documents);
+                } else {
+                    search_server.AddDocuments(documents);
+                }
+                assert(false);
+            } catch (const AddDocumentsError& error) {
+                [[maybe_unused]] const vector<AddDocumentsError::Failure>& failures = error.GetFailures();
+                assert(failures.size() == 4);
+                assert(failures[0].position == texts.size() && failures[0].document_id == 3);
+                assert(failures[1].document_id == -1 && failures[2].document_id == 100'000);
+                assert(failures[3].position == documents.size() - 1 && failures[3].document_id == 100'002);
+            }
+            assert(search_server.GetDocumentCount() == expected_server.GetDocumentCount());
+            assert(equal(search_server.begin(), search_server.end(), expected_server.begin(), expected_server.end()));
+            assert(search_server.GetWordFrequencies(17) == expected_server.GetWordFrequencies(17));
+            for (int i = 0; i < 100; ++i) {
+                const string query = GenerateQuery(generator, dictionary, 4, 0.1);
+                for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                    const vector<Document> expected = expected_server.FindTopDocuments(query, status);
+                    const vector<Document> found = search_server.FindTopDocuments(query, status);
+                    assert(found.size() == expected.size());
+                    for (size_t j = 0; j < expected.size(); ++j) {
+                        assert(found[j].id == expected[j].id && found[j].relevance == expected[j].relevance
+                            && found[j].rating == expected[j].rating);
+                    }
+                }
+            }
+        }
+        cerr << ">>> TestAddDocuments has been passed"sv << endl;
+    }
+
+    void TestConcurrentSearchServer() {
+        // Документы добавляются и удаляются парами (2k, 2k + 1) за одну запись,
+        // поэтому читатель любой опубликованной версии видит только целые пары
+        constexpr int kInitialPairCount = 100;
+        constexpr int kWriteCount = 300;
+        constexpr int kReaderCount = 4;
+        ConcurrentSearchServer search_server("and with"s);
+        const auto add_pair = [](SearchServer& server, int pair) {
+            const string text = "common word"s + to_string(pair % 10) + " and tail"s;
+            server.AddDocument(pair * 2, text, DocumentStatus::ACTUAL, { pair });
+            server.AddDocument(pair * 2 + 1, text, DocumentStatus::ACTUAL, { pair });
+        };
+        for (int pair = 0; pair < kInitialPairCount; ++pair) {
+            search_server.Write([&](SearchServer& server) {
+                add_pair(server, pair);
+            });
+        }
+
+        atomic<bool> is_writing = true;
+        atomic<int> read_count = 0;
+        vector<thread> readers;
+        for (int i = 0; i < kReaderCount; ++i) {
+            readers.emplace_back([&] {
+                while (is_writing || read_count < kReaderCount) {
+                    search_server.Read([](const SearchServer& server) {
+                        const vector<Document> documents = server.FindTopDocuments("common -missing"s,
+                            [](int, DocumentStatus, int) { return true; }, 1'000'000);
+                        assert(static_cast<int>(documents.size()) == server.GetDocumentCount());
+                        set<int> ids;
+                        for (const Document& document : documents) {
+                            ids.insert(document.id);
+                        }
+                        for ([[maybe_unused]] const int id : ids) {
+                            assert(ids.count(id ^ 1) > 0);
+                        }
+                    });
+                    ++read_count;
+                }
+            });
+        }
+        for (int i = 0; i < kWriteCount; ++i) {
+            search_server.Write([&](SearchServer& server) {
+                add_pair(server, kInitialPairCount + i);
+                server.RemoveDocument(i * 2);
+                server.RemoveDocument(i * 2 + 1);
+            });
+        }
+        is_writing = false;
+        for (thread& reader : readers) {
+            reader.join();
+        }
+        assert(search_server.GetDocumentCount() == kInitialPairCount * 2);
+        assert(search_server.FindTopDocuments("tail"s).size() == MAX_RESULT_DOCUMENT_COUNT);
+
+        {
+            // дубликаты удаляются на обоих экземплярах
+            ConcurrentSearchServer duplicates_server("and with"s);
+            duplicates_server.AddDocument(1, "white cat and hat"s, DocumentStatus::ACTUAL, { 1 });
+            duplicates_server.AddDocument(2, "curly dog"s, DocumentStatus::ACTUAL, { 1 });
+            duplicates_server.AddDocument(3, "hat with white cat"s, DocumentStatus::ACTUAL, { 1 });
+            RemoveDuplicates(duplicates_server);
+            assert(duplicates_server.GetDocumentCount() == 2);
+            duplicates_server.Write([](SearchServer&) {});
+            assert(duplicates_server.GetDocumentCount() == 2);
+        }
+        cerr << ">>> TestConcurrentSearchServer has been passed"sv << endl;
+    }
+
+    void TestSegments() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 300, 6);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 3'000, 10);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { static_cast<int>(i % 7) } });
+        }
+        vector<string> queries;
+        for (int i = 0; i < 100; ++i) {
+            queries.push_back(GenerateQuery(generator, dictionary, 4, 0.1));
+        }
+        const auto assert_equal_results = []([[maybe_unused]] const vector<Document>& found, const vector<Document>& expected) {
+            assert(found.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                assert(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance);
+            }
+        };
+
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            // в эталонном сервере все документы остаются в изменяемом сегменте
+            SearchServer expected_server("stop"s, format);
+            SearchServer search_server("stop"s, format);
+            search_server.SetSegmentDocumentCount(50);
+            const size_t half = documents.size() / 2;
+            for (size_t i = 0; i < half; ++i) {
+                const DocumentToAdd& document = documents[i];
+                expected_server.AddDocument(document.id, document.text, document.status, document.ratings);
+                search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+                if (i % 5 == 4 && i >= 10) {
+                    expected_server.RemoveDocument(static_cast<int>(i) - 10 * (i % 2));
+                    search_server.RemoveDocument(static_cast<int>(i) - 10 * (i % 2));
+                }
+            }
+            const vector<DocumentToAdd> rest(documents.begin() + half, documents.end());
+            expected_server.AddDocuments(rest);
+            search_server.AddDocuments(execution::par, rest);
+            for (int id = 0; id < static_cast<int>(documents.size()); id += 13) {
+                if (expected_server.GetWordFrequencies(id).size() > 0) {
+                    expected_server.RemoveDocument(id);
+                    search_server.RemoveDocument(execution::par, id);
+                }
+            }
+            assert(search_server.GetSealedSegmentCount() > 0);
+
+            for (const bool wait : { false, true }) {
+                if (wait) {
+                    // 30 сегментов по 50 документов и один сегмент пакета сливаются не более чем в 7
+                    search_server.WaitForMerges();
+                    assert(search_server.GetSealedSegmentCount() <= 7);
+                }
+                assert(search_server.GetDocumentCount() == expected_server.GetDocumentCount());
+                for (const string& query : queries) {
+                    assert_equal_results(search_server.FindTopDocuments(query), expected_server.FindTopDocuments(query));
+                    assert_equal_results(search_server.FindTopDocuments(execution::par, query),
+                        expected_server.FindTopDocuments(query));
+                }
+                const QueryResults found = search_server.FindTopDocumentsBatch(queries);
+                for (size_t i = 0; i < queries.size(); ++i) {
+                    const vector<Document> expected = expected_server.FindTopDocuments(queries[i]);
+                    assert_equal_results(vector<Document>(found[i].begin(), found[i].end()), expected);
+                }
+                const auto [words, status] = search_server.MatchDocument(queries.front(), 1);
+                assert(words == get<0>(expected_server.MatchDocument(queries.front(), 1)));
+            }
+        }
+        cerr << ">>> TestSegments has been passed"sv << endl;
+    }
+
+    void TestRemoveDuplicates() {
+        using namespace test_policies;
+        // сообщения об удалённых дубликатах в тесте не нужны
+        ostringstream removed_output;
+        streambuf* const cout_buffer = cout.rdbuf(removed_output.rdbuf());
+
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 6, 3);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 300, 4);
+        SearchServer search_server("stop"s);
+        set<int> expected_ids;
+        set<set<string>> word_sets;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            const int id = static_cast<int>(i) * 3;
+            search_server.AddDocument(id, texts[i], DocumentStatus::ACTUAL, { 1 });
+            const vector<string_view> words = SplitIntoWords(texts[i]);
+            if (word_sets.emplace(words.begin(), words.end()).second) {
+                expected_ids.insert(id);
+            }
+        }
+        RemoveDuplicates(search_server);
+        assert(set<int>(search_server.begin(), search_server.end()) == expected_ids);
+
+        const auto make_server = [] {
+            SearchServer server("and"s);
+            server.AddDocument(1, "a b c d e f g h i j"s, DocumentStatus::ACTUAL, { 1 });
+            server.AddDocument(2, "a b c d e f g h i k"s, DocumentStatus::ACTUAL, { 1 });
+            server.AddDocument(3, "x y and z"s, DocumentStatus::ACTUAL, { 1 });
+            server.AddDocument(4, "j i h g f e d c b a a"s, DocumentStatus::ACTUAL, { 1 });
+            server.AddDocument(5, "x y z w"s, DocumentStatus::ACTUAL, { 1 });
+            return server;
+        };
+        {
+            // сходство 2 с 1 равно 9/11, 5 с 3 - 3/4
+            SearchServer server = make_server();
+            RemoveDuplicates(server, 0.8);
+            assert(set<int>(server.begin(), server.end()) == set<int>({ 1, 3, 5 }));
+        }
+        {
+            SearchServer server = make_server();
+            RemoveDuplicates(server, 0.7);
+            assert(set<int>(server.begin(), server.end()) == set<int>({ 1, 3 }));
+        }
+        {
+            SearchServer server = make_server();
+            try {
+                RemoveDuplicates(server, 0.0);
+                assert(false);
+            } catch (const invalid_argument&) {
+            }
+            assert(server.GetDocumentCount() == 5);
+        }
+        cout.rdbuf(cout_buffer);
+        cerr << ">>> TestRemoveDuplicates has been passed"sv << endl;
+    }
+
+    void TestSplitIntoWords() {
+        // побайтовое разбиение, с которым сверяется векторное
+        [[maybe_unused]] const auto split_by_bytes = [](string_view text) {
+            vector<string_view> words;
+            size_t word_begin = 0;
+            for (size_t i = 0; i <= text.size(); ++i) {
+                if (i == text.size() || text[i] == ' ') {
+                    if (i > word_begin) {
+                        words.push_back(text.substr(word_begin, i - word_begin));
+                    }
+                    word_begin = i + 1;
+                }
+            }
+            return words;
+        };
+        mt19937 generator;
+        const string alphabet = "  ab\xC0\xFF\x7F\t\x1F"s;
+        vector<string_view> words;
+        for (int i = 0; i < 2'000; ++i) {
+            string text(uniform_int_distribution<size_t>(0, 70)(generator), ' ');
+            // управляющие символы есть примерно в каждом пятом тексте
+            const bool with_control_characters = i % 5 == 0;
+            for (char& c : text) {
+                c = alphabet[uniform_int_distribution<size_t>(0, with_control_characters ? alphabet.size() - 1 : 6)(generator)];
+            }
+            [[maybe_unused]] const bool is_valid = none_of(text.begin(), text.end(), [](char c) {
+                return static_cast<unsigned char>(c) < ' ';
+            });
+            assert(SplitIntoWords(text, words) == is_valid);
+            assert(HasControlCharacters(text) == !is_valid);
+            assert(words == split_by_bytes(text));
+            assert(SplitIntoWords(text) == words);
+        }
+        assert(SplitIntoWords("   "sv, words) && words.empty());
+        assert(SplitIntoWords(" white cat  and\xC0 fashionable collar "sv, words) && words.size() == 5 && words[2] == "and\xC0"sv);
+
+        SearchServer search_server("and"s);
+        try {
+            search_server.AddDocument(1, "a rather long document text with\x01 a control character"s, DocumentStatus::ACTUAL, {});
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        assert(search_server.GetDocumentCount() == 0);
+        try {
+            search_server.FindTopDocuments("cat and a long query with a control\x1F character"s);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        cerr << ">>> TestSplitIntoWords has been passed"sv << endl;
+    }
+
+    void TestQueryContext() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 200, 6);
+        const vector<string> documents = GenerateQueries(generator, dictionary, 2'000, 10);
+        vector<string> queries;
+        for (int i = 0; i < 50; ++i) {
+            queries.push_back(GenerateQuery(generator, dictionary, 5, 0.2) + " and -in"s);
+        }
+        SearchServer search_server("and in the"s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i] + " the"s,
+                i % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { static_cast<int>(i % 5) });
+        }
+
+        SearchServer::QueryContext context;
+        for (const string& query : queries) {
+            const vector<Document> expected = search_server.FindTopDocuments(query);
+            [[maybe_unused]] const vector<Document>& found = search_server.FindTopDocuments(context, query);
+            assert(found.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                assert(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance);
+            }
+        }
+        // после прогрева контекста запросы не выделяют память
+        [[maybe_unused]] const size_t allocations_before = GetAllocationCount();
+        size_t found_count = 0;
+        for (int repeat = 0; repeat < 3; ++repeat) {
+            for (const string& query : queries) {
+                found_count += search_server.FindTopDocuments(context, query).size();
+                found_count += search_server.FindTopDocuments(context, query, DocumentStatus::BANNED, 10).size();
+            }
+        }
+        assert(GetAllocationCount() == allocations_before);
+        assert(found_count > 0);
+        // стоп-слова не становятся словами запроса
+        assert(search_server.FindTopDocuments(context, "the and"s).empty());
+        cerr << ">>> TestQueryContext has been passed"sv << endl;
+    }
+
+    void TestInverseDocumentFreqCache() {
+        SearchServer search_server("and"s);
+        search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+        search_server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, { 2 });
+        // IDF после каждого изменения совпадает с вычисленным заново
+        const auto assert_cat_relevance = [&search_server]([[maybe_unused]] int document_count, [[maybe_unused]] int cat_document_count) {
+            const vector<Document> documents = search_server.FindTopDocuments("cat"s);
+            assert(documents.size() == static_cast<size_t>(cat_document_count));
+            // у документа 1 частота слова 1/2
+            assert(documents.back().id == 1);
+            assert(documents.back().relevance == 0.5 * log(document_count * 1.0 / cat_document_count));
+        };
+        assert_cat_relevance(2, 1);
+        assert_cat_relevance(2, 1);
+        search_server.AddDocument(3, "grey dog"s, DocumentStatus::ACTUAL, { 3 });
+        assert_cat_relevance(3, 1);
+        search_server.AddDocument(4, "cat and cat"s, DocumentStatus::ACTUAL, { 0 });
+        assert_cat_relevance(4, 2);
+        search_server.RemoveDocument(2);
+        assert_cat_relevance(3, 2);
+        search_server.AddDocuments(execution::par, vector<DocumentToAdd>{ { 5, "fluffy dog"sv, DocumentStatus::ACTUAL, {} } });
+        assert_cat_relevance(4, 2);
+        cerr << ">>> TestInverseDocumentFreqCache has been passed"sv << endl;
+    }
+
+    void TestDynamicPruning() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 300, 6);
+        vector<string> texts;
+        for (int i = 0; i < 3'000; ++i) {
+            texts.push_back(GenerateQuery(generator, dictionary, uniform_int_distribution<int>(1, 12)(generator), 0.0));
+        }
+        vector<string> queries;
+        for (int i = 0; i < 100; ++i) {
+            queries.push_back(GenerateQuery(generator, dictionary, uniform_int_distribution<int>(1, 6)(generator), 0.15));
+        }
+        const string path = (filesystem::temp_directory_path() / "search_server_pruning_test.snapshot"s).string();
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            SearchServer search_server(""s, format);
+            search_server.SetSegmentDocumentCount(200);
+            for (size_t i = 0; i < texts.size(); ++i) {
+                search_server.AddDocument(static_cast<int>(i), texts[i], i % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+                    { static_cast<int>(i % 3) });
+            }
+            for (int i = 0; i < 3'000; i += 7) {
+                search_server.RemoveDocument(i);
+            }
+            // отсечение не меняет ни состав, ни порядок, ни релевантность выдачи
+            const auto assert_same_results = [&queries](SearchServer& server) {
+                SearchServer::QueryContext context;
+                size_t exhaustive_posting_count = 0;
+                size_t pruned_posting_count = 0;
+                for (const string& query : queries) {
+                    for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                        for (const size_t max_result_count : { 1, 5, 50 }) {
+                            server.SetDynamicPruning(false);
+                            const vector<Document> expected = server.FindTopDocuments(context, query, status, max_result_count);
+                            exhaustive_posting_count += context.GetEvaluatedPostingCount();
+                            server.SetDynamicPruning(true);
+                            [[maybe_unused]] const vector<Document>& found = server.FindTopDocuments(context, query, status, max_result_count);
+                            pruned_posting_count += context.GetEvaluatedPostingCount();
+                            assert(found.size() == expected.size());
+                            for (size_t i = 0; i < expected.size(); ++i) {
+                                assert(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance);
+                            }
+                        }
+                    }
+                    server.SetDynamicPruning(true);
+                    const auto even_id = [](int document_id, DocumentStatus, int) {
+                        return document_id % 2 == 0;
+                    };
+                    const vector<Document> found = server.FindTopDocuments(query, even_id);
+                    server.SetDynamicPruning(false);
+                    const vector<Document> expected = server.FindTopDocuments(query, even_id);
+                    assert(found.size() == expected.size());
+                    for (size_t i = 0; i < expected.size(); ++i) {
+                        assert(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance);
+                    }
+                }
+                assert(pruned_posting_count < exhaustive_posting_count);
+            };
+            assert(search_server.GetSealedSegmentCount() > 1);
+            assert_same_results(search_server);
+            search_server.SaveSnapshot(path);
+            SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+            assert_same_results(loaded_server);
+        }
+        filesystem::remove(path);
+        cerr << ">>> TestDynamicPruning has been passed"sv << endl;
+    }
+
+    void TestRequiredWords() {
+        using namespace test_policies;
+        {
+            SearchServer search_server("and"s);
+            search_server.AddDocument(1, "white cat and fashion collar"s, DocumentStatus::ACTUAL, { 8 });
+            search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7 });
+            search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5 });
+            search_server.AddDocument(4, "fluffy dog"s, DocumentStatus::ACTUAL, { 1 });
+            vector<Document> documents = search_server.FindTopDocuments("+fluffy cat"s);
+            assert(documents.size() == 2 && documents[0].id == 2 && documents[1].id == 4);
+            assert(search_server.FindTopDocuments("+fluffy +cat"s).size() == 1);
+            assert(search_server.FindTopDocuments(execution::par, "+fluffy +cat -tail"s).empty());
+            assert(search_server.FindTopDocuments("+parrot cat"s).empty());
+            // обязательное стоп-слово не учитывается, как и обычное
+            assert(search_server.FindTopDocuments("+and +collar"s).size() == 1);
+            const auto [words, status] = search_server.MatchDocument("+dog cat"s, 1);
+            assert(words.empty());
+            // найденные слова указывают в текст запроса
+            const string dog_query = "+dog groomed"s;
+            const auto [dog_words, dog_status] = search_server.MatchDocument(execution::par, dog_query, 3);
+            assert((dog_words == vector<string_view>{ "dog"sv, "groomed"sv }));
+            for (const string& query : { "+"s, "++cat"s, "+-cat"s }) {
+                try {
+                    search_server.FindTopDocuments(query);
+                    assert(false);
+                } catch (const invalid_argument&) {
+                }
+            }
+            // ключ кеша различает обязательные слова
+            search_server.SetQueryCacheMemoryLimit(1 << 20);
+            assert(search_server.FindTopDocuments("fluffy cat"s).size() == 3);
+            assert(search_server.FindTopDocuments("+fluffy cat"s).size() == 2);
+        }
+        // документы запроса с обязательным словом и их релевантность - те же, что у запроса без плюса,
+        // из которого убраны документы без этого слова
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 100, 5);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 3'000, 10);
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            SearchServer search_server(""s, format);
+            search_server.SetSegmentDocumentCount(300);
+            for (size_t i = 0; i < texts.size(); ++i) {
+                search_server.AddDocument(static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { static_cast<int>(i % 7) });
+            }
+            for (int i = 0; i < 3'000; i += 11) {
+                search_server.RemoveDocument(i);
+            }
+            for (int i = 0; i < 100; ++i) {
+                const string required_word = dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+                const string other_words = GenerateQuery(generator, dictionary, 3, 0.2);
+                const auto has_required_word = [&](int document_id) {
+                    const map<string_view, double>& word_frequencies = search_server.GetWordFrequencies(document_id);
+                    return word_frequencies.count(required_word) > 0;
+                };
+                vector<Document> expected = search_server.FindTopDocuments(required_word + " "s + other_words,
+                    [&](int document_id, DocumentStatus, int) {
+                        return has_required_word(document_id);
+                    }, texts.size());
+                for ([[maybe_unused]] const auto& policy_results : { search_server.FindTopDocuments("+"s + required_word + " "s + other_words,
+                                                        DocumentStatus::ACTUAL, texts.size()),
+                                                    search_server.FindTopDocuments(execution::par, "+"s + required_word + " "s + other_words,
+                                                        DocumentStatus::ACTUAL, texts.size()) }) {
+                    assert(policy_results.size() == expected.size());
+                    for (size_t j = 0; j < expected.size(); ++j) {
+                        assert(policy_results[j].id == expected[j].id && policy_results[j].relevance == expected[j].relevance);
+                    }
+                }
+                const QueryResults batch_results = search_server.FindTopDocumentsBatch({ "+"s + required_word + " "s + other_words },
+                    DocumentStatus::ACTUAL, texts.size());
+                assert(batch_results.GetQueryCount() == 1 && batch_results[0].size() == expected.size());
+            }
+        }
+        cerr << ">>> TestRequiredWords has been passed"sv << endl;
+    }
+
+    void TestStatusPartitions() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 30, 5);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 4'000, 10);
+        const auto get_status = [](int document_id) {
+            return document_id % 97 == 0 ? DocumentStatus::IRRELEVANT
+                : document_id % 50 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        };
+        vector<string> queries;
+        for (int i = 0; i < 50; ++i) {
+            queries.push_back(GenerateQuery(generator, dictionary, 3, 0.2));
+        }
+        queries.push_back("+"s + dictionary[0] + " "s + dictionary[1]);
+        const string path = (filesystem::temp_directory_path() / "search_server_status_test.snapshot"s).string();
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            SearchServer search_server(""s, format);
+            search_server.SetSegmentDocumentCount(500);
+            for (size_t i = 0; i < texts.size(); ++i) {
+                const int document_id = static_cast<int>(i);
+                search_server.AddDocument(document_id, texts[i], get_status(document_id), { document_id % 5 });
+            }
+            // удаление большей части документов статуса сжимает его номера
+            for (int i = 0; i < 4'000; i += 97) {
+                if (i % 3 != 0) {
+                    search_server.RemoveDocument(i);
+                }
+            }
+            for (int i = 0; i < 4'000; i += 13) {
+                if (i % 97 != 0) {
+                    search_server.RemoveDocument(i);
+                }
+            }
+            // поиск по статусу находит то же, что произвольный предикат с проверкой того же статуса
+            const auto assert_same_results = [&](SearchServer& server) {
+                SearchServer::QueryContext context;
+                for (const string& query : queries) {
+                    // частый статус проверяется по спискам слов
+                    server.SetDynamicPruning(false);
+                    server.FindTopDocuments(context, query, DocumentStatus::ACTUAL, texts.size());
+                    [[maybe_unused]] const size_t actual_posting_count = context.GetEvaluatedPostingCount();
+                    for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::IRRELEVANT }) {
+                        server.SetDynamicPruning(false);
+                        const vector<Document> expected = server.FindTopDocuments(query, [status](int, DocumentStatus document_status, int) {
+                            return document_status == status;
+                        }, texts.size());
+                        const QueryResults batch_results = server.FindTopDocumentsBatch({ query }, status, texts.size());
+                        server.SetDynamicPruning(true);
+                        const vector<Document> pruned = server.FindTopDocuments(context, query, status, 5);
+                        assert(pruned.size() == min<size_t>(expected.size(), 5));
+                        for ([[maybe_unused]] const auto& found : { server.FindTopDocuments(query, status, texts.size()),
+                                                   server.FindTopDocuments(execution::par, query, status, texts.size()),
+                                                   vector<Document>(batch_results[0].begin(), batch_results[0].end()) }) {
+                            assert(found.size() == expected.size());
+                            for (size_t i = 0; i < expected.size(); ++i) {
+                                assert(found[i].id == expected[i].id && found[i].relevance == expected[i].relevance);
+                                assert(i >= pruned.size() || pruned[i].id == expected[i].id);
+                            }
+                        }
+                        server.SetDynamicPruning(false);
+                        server.FindTopDocuments(context, query, status, texts.size());
+                        // редкий статус проверяется только по своим документам
+                        if (status != DocumentStatus::ACTUAL) {
+                            assert(context.GetEvaluatedPostingCount() < actual_posting_count);
+                        }
+                    }
+                }
+            };
+            assert_same_results(search_server);
+            search_server.SaveSnapshot(path);
+            SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+            assert_same_results(loaded_server);
+            loaded_server.AddDocument(4'000, dictionary[0], DocumentStatus::IRRELEVANT, { 1 });
+            const vector<Document> documents = loaded_server.FindTopDocuments(dictionary[0], DocumentStatus::IRRELEVANT);
+            assert(any_of(documents.begin(), documents.end(), [](const Document& document) {
+                return document.id == 4'000;
+            }));
+        }
+        filesystem::remove(path);
+        cerr << ">>> TestStatusPartitions has been passed"sv << endl;
+    }
+
+    void TestMatchDocuments() {
+        using namespace test_policies;
+        {
+            SearchServer search_server("and"s);
+            search_server.AddDocument(1, "white cat and fashion collar"s, DocumentStatus::ACTUAL, { 8 });
+            search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::BANNED, { 7 });
+            search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5 });
+            const string query = "tail cat fluffy cat parrot -eyes"s;
+            const vector<SearchServer::words_and_status_document> matches = search_server.MatchDocuments(execution::par, query, { 2, 1, 3 });
+            assert(matches.size() == 3);
+            // слова различны и упорядочены, статус - документа
+            assert((get<0>(matches[0]) == vector<string_view>{ "cat"sv, "fluffy"sv, "tail"sv }));
+            assert(get<1>(matches[0]) == DocumentStatus::BANNED);
+            assert((get<0>(matches[1]) == vector<string_view>{ "cat"sv }));
+            assert(get<0>(matches[2]).empty());
+            assert(search_server.MatchDocuments(execution::seq, query, {}).empty());
+            try {
+                search_server.MatchDocuments(execution::par, query, { 1, 4 });
+                assert(false);
+            } catch (const out_of_range&) {
+            }
+        }
+        // пакет совпадает с сопоставлением каждого документа по отдельности
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 50, 5);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 1'000, 10);
+        SearchServer search_server(dictionary[0]);
+        search_server.SetSegmentDocumentCount(300);
+        for (size_t i = 0; i < texts.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), texts[i], i % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { 1 });
+        }
+        for (int i = 0; i < 1'000; i += 7) {
+            search_server.RemoveDocument(i);
+        }
+        const vector<int> document_ids(search_server.begin(), search_server.end());
+        for (int i = 0; i < 50; ++i) {
+            string query = GenerateQuery(generator, dictionary, 5, 0.2);
+            if (i % 2 == 0) {
+                query += " +"s + dictionary[uniform_int_distribution<size_t>(1, dictionary.size() - 1)(generator)];
+            }
+            const auto sequenced_matches = search_server.MatchDocuments(execution::seq, query, document_ids);
+            const auto parallel_matches = search_server.MatchDocuments(execution::par, query, document_ids);
+            assert(sequenced_matches == parallel_matches && sequenced_matches.size() == document_ids.size());
+            for (size_t j = 0; j < document_ids.size(); j += 17) {
+                assert(sequenced_matches[j] == search_server.MatchDocument(execution::par, query, document_ids[j]));
+            }
+        }
+        cerr << ">>> TestMatchDocuments has been passed"sv << endl;
+    }
+
+    void TestRemoveDocuments() {
+        using namespace test_policies;
+        {
+            SearchServer search_server(""s);
+            for (int i = 0; i < 1'000; ++i) {
+                search_server.AddDocument(i, "word"s + to_string(i) + " common"s, DocumentStatus::ACTUAL, { 1 });
+            }
+            try {
+                search_server.RemoveDocuments(execution::par, { 1, 1'000 });
+                assert(false);
+            } catch (const invalid_argument&) {
+            }
+            assert(search_server.GetDocumentCount() == 1'000);
+            // списки слов, оставшихся без документов, освобождаются
+            [[maybe_unused]] const size_t memory_usage = search_server.GetPostingsMemoryUsage();
+            vector<int> even_ids;
+            for (int i = 0; i < 1'000; i += 2) {
+                even_ids.push_back(i);
+            }
+            even_ids.push_back(0);
+            search_server.RemoveDocuments(execution::par, even_ids);
+            assert(search_server.GetDocumentCount() == 500);
+            assert(search_server.GetPostingsMemoryUsage() < memory_usage);
+            assert(search_server.FindTopDocuments("word2"s).empty());
+            assert(search_server.FindTopDocuments("word3"s).size() == 1);
+            search_server.AddDocument(2, "word2"s, DocumentStatus::ACTUAL, { 1 });
+            assert(search_server.FindTopDocuments("word2"s).size() == 1);
+        }
+        // запечатанный сегмент, в котором не осталось документов, освобождается без слияния
+        {
+            SearchServer search_server(""s);
+            search_server.SetSegmentDocumentCount(100);
+            for (int i = 0; i < 1'000; ++i) {
+                search_server.AddDocument(i, "word"s + to_string(i) + " common"s, DocumentStatus::ACTUAL, { 1 });
+            }
+            search_server.WaitForMerges();
+            [[maybe_unused]] const size_t segment_count = search_server.GetSealedSegmentCount();
+            vector<int> first_ids(500);
+            iota(first_ids.begin(), first_ids.end(), 0);
+            search_server.RemoveDocuments(execution::seq, first_ids);
+            assert(search_server.GetSealedSegmentCount() < segment_count);
+            assert(search_server.FindTopDocuments("common"s, DocumentStatus::ACTUAL, 1'000).size() == 500);
+            assert(search_server.FindTopDocuments("word500"s).size() == 1);
+        }
+        // после удаления пакета выдача та же, что у сервера, в который удалённые документы не добавлялись
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 200, 5);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 3'000, 10);
+        const vector<string> queries = GenerateQueries(generator, dictionary, 100, 4);
+        const auto is_removed = [](int document_id) {
+            return document_id % 3 == 0 || document_id % 7 == 0;
+        };
+        SearchServer expected_server(""s);
+        vector<int> removed_ids;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            if (is_removed(static_cast<int>(i))) {
+                removed_ids.push_back(static_cast<int>(i));
+            } else {
+                expected_server.AddDocument(static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1 });
+            }
+        }
+        for (const PostingListFormat format : { PostingListFormat::PLAIN, PostingListFormat::COMPRESSED }) {
+            SearchServer sequenced_server(""s, format);
+            SearchServer parallel_server(""s, format);
+            for (SearchServer* search_server : { &sequenced_server, &parallel_server }) {
+                search_server->SetSegmentDocumentCount(700);
+                for (size_t i = 0; i < texts.size(); ++i) {
+                    search_server->AddDocument(static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1 });
+                }
+            }
+            sequenced_server.RemoveDocuments(execution::seq, removed_ids);
+            parallel_server.RemoveDocuments(execution::par, removed_ids);
+            for (SearchServer* search_server : { &sequenced_server, &parallel_server }) {
+                assert(search_server->GetDocumentCount() == expected_server.GetDocumentCount());
+                for (const string& query : queries) {
+                    const vector<Document> expected = expected_server.FindTopDocuments(query);
+                    const vector<Document> found = search_server->FindTopDocuments(query);
+                    assert(found.size() == expected.size());
+                    for (size_t i = 0; i < expected.size(); ++i) {
+                        assert(found[i].id == expected[i].id && abs(found[i].relevance - expected[i].relevance) < 1e-12);
+                    }
+                }
+            }
+        }
+        cerr << ">>> TestRemoveDocuments has been passed"sv << endl;
+    }
+
+    void TestDocumentIdOrder() {
+        using namespace test_policies;
+        const string path = (filesystem::temp_directory_path() / "search_server_id_order_test.snapshot"s).string();
+        SearchServer search_server("and"s);
+        const vector<int> added_ids = { 7, 3, 100, 42, 0, 15 };
+        for (const int document_id : added_ids) {
+            search_server.AddDocument(document_id, "cat "s + to_string(document_id), DocumentStatus::ACTUAL, { document_id });
+        }
+        // обход идёт по возрастанию id независимо от порядка добавления
+        assert(vector<int>(search_server.begin(), search_server.end()) == vector<int>({ 0, 3, 7, 15, 42, 100 }));
+        search_server.RemoveDocuments(execution::seq, { 42, 0 });
+        search_server.AddDocument(200, "cat dog"s, DocumentStatus::BANNED, { 5 });
+        search_server.AddDocument(1, "dog"s, DocumentStatus::ACTUAL, { 9 });
+        const vector<int> expected_ids = { 1, 3, 7, 15, 100, 200 };
+        assert(vector<int>(search_server.begin(), search_server.end()) == expected_ids);
+        assert(search_server.GetDocumentCount() == 6);
+
+        search_server.SaveSnapshot(path);
+        SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+        assert(vector<int>(loaded_server.begin(), loaded_server.end()) == expected_ids);
+        // рейтинг и статус восстанавливаются по номеру документа
+        const vector<Document> found = loaded_server.FindTopDocuments("dog"s, DocumentStatus::BANNED);
+        assert(found.size() == 1 && found[0].id == 200 && found[0].rating == 5);
+        assert(loaded_server.FindTopDocuments("cat"s).size() == 4);
+        try {
+            loaded_server.AddDocument(3, "duplicate"s, DocumentStatus::ACTUAL, { 1 });
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        loaded_server.AddDocument(42, "cat"s, DocumentStatus::ACTUAL, { 1 });
+        assert(loaded_server.GetDocumentCount() == 7);
+        filesystem::remove(path);
+        cerr << ">>> TestDocumentIdOrder has been passed"sv << endl;
+    }
+
+    void TestShardedSearchServer() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 300, 6);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 2'000, 12);
+        const vector<string> queries = GenerateQueries(generator, dictionary, 200, 4);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            const DocumentStatus status = i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+            documents.push_back({ static_cast<int>(i * 3), texts[i], status, { static_cast<int>(i % 17) - 8 } });
+        }
+        SearchServer expected_server(dictionary[0]);
+        expected_server.AddDocuments(documents);
+        for (const size_t shard_count : { 1, 3, 8 }) {
+            ShardedSearchServer search_server(shard_count, dictionary[0]);
+            assert(search_server.GetShardCount() == shard_count);
+            // половина документов добавляется по одному, половина - пакетом
+            const size_t half = documents.size() / 2;
+            for (size_t i = 0; i < half; ++i) {
+                search_server.AddDocument(documents[i].id, documents[i].text, documents[i].status, documents[i].ratings);
+            }
+            search_server.AddDocuments(vector<DocumentToAdd>(documents.begin() + half, documents.end()));
+            assert(search_server.GetDocumentCount() == expected_server.GetDocumentCount());
+            if (shard_count > 1) {
+                // документы действительно разложены по нескольким шардам
+                assert(search_server.GetShard(0).GetDocumentCount() < search_server.GetDocumentCount());
+            }
+            try {
+                search_server.AddDocuments(vector<DocumentToAdd>{ { 100'000, "new"s, DocumentStatus::ACTUAL, { 1 } },
+                    { 3, "duplicate"s, DocumentStatus::ACTUAL, { 1 } }, { -1, "negative"s, DocumentStatus::ACTUAL, { 1 } } });
+                assert(false);
+            } catch (const AddDocumentsError& error) {
+                [[maybe_unused]] const vector<AddDocumentsError::Failure>& failures = error.GetFailures();
+                assert(failures.size() == 2);
+                assert(failures[0].position == 1 && failures[0].document_id == 3);
+                assert(failures[1].position == 2 && failures[1].document_id == -1);
+            }
+            search_server.RemoveDocument(100'000);
+
+            const auto check_queries = [&](const SearchServer& expected_server) {
+                for (const string& query : queries) {
+                    for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                        const vector<Document> expected = expected_server.FindTopDocuments(query, status);
+                        const vector<Document> found = search_server.FindTopDocuments(query, status);
+                        assert(found.size() == expected.size());
+                        for (size_t i = 0; i < expected.size(); ++i) {
+                            assert(found[i].id == expected[i].id && found[i].rating == expected[i].rating);
+                            assert(abs(found[i].relevance - expected[i].relevance) < 1e-12);
+                        }
+                    }
+                    const auto is_positive = [](int, DocumentStatus, int rating) {
+                        return rating > 0;
+                    };
+                    const vector<Document> expected = expected_server.FindTopDocuments(query, is_positive, 20);
+                    const vector<Document> found = search_server.FindTopDocuments(query, is_positive, 20);
+                    assert(found.size() == expected.size());
+                    for (size_t i = 0; i < expected.size(); ++i) {
+                        assert(found[i].id == expected[i].id);
+                    }
+                }
+            };
+            check_queries(expected_server);
+
+            // после удаления IDF пересчитывается по оставшимся документам всех шардов
+            SearchServer reduced_server(dictionary[0]);
+            for (const DocumentToAdd& document : documents) {
+                if (document.id % 2 == 0) {
+                    search_server.RemoveDocument(document.id);
+                } else {
+                    reduced_server.AddDocument(document.id, document.text, document.status, document.ratings);
+                }
+            }
+            assert(search_server.GetDocumentCount() == reduced_server.GetDocumentCount());
+            check_queries(reduced_server);
+            const auto [words, status] = search_server.MatchDocument(texts[1], 3);
+            assert(words == get<0>(reduced_server.MatchDocument(texts[1], 3)) && status == DocumentStatus::ACTUAL);
+            try {
+                search_server.RemoveDocument(0);
+                assert(false);
+            } catch (const invalid_argument&) {
+            }
+        }
+        cerr << ">>> TestShardedSearchServer has been passed"sv << endl;
+    }
+
+    void TestShardRpc() {
+        using namespace test_policies;
+        mt19937 generator;
+        const vector<string> dictionary = GenerateDictionary(generator, 300, 6);
+        const vector<string> texts = GenerateQueries(generator, dictionary, 1'000, 12);
+        vector<string> queries = GenerateQueries(generator, dictionary, 200, 4);
+        vector<DocumentToAdd> documents;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            const DocumentStatus status = i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+            documents.push_back({ static_cast<int>(i * 3), texts[i], status, { static_cast<int>(i % 17) - 8 } });
+        }
+
+        // шарды обслуживают настоящие сокеты, но работают в потоках этого процесса
+        constexpr size_t SHARD_COUNT = 3;
+        vector<string> socket_paths;
+        vector<unique_ptr<SearchServer>> shards;
+        vector<thread> shard_threads;
+        for (size_t shard = 0; shard < SHARD_COUNT; ++shard) {
+            socket_paths.push_back((filesystem::temp_directory_path() / ("search_server_test_shard_"s + to_string(shard) + ".sock"s)).string());
+            shards.push_back(make_unique<SearchServer>(dictionary[0]));
+            shard_threads.emplace_back(ServeShard, ref(*shards.back()), socket_paths.back());
+        }
+        ShardCoordinator coordinator(socket_paths);
+        assert(coordinator.GetShardCount() == SHARD_COUNT);
+
+        const size_t half = documents.size() / 2;
+        for (size_t i = 0; i < half; ++i) {
+            coordinator.AddDocument(documents[i].id, documents[i].text, documents[i].status, documents[i].ratings);
+        }
+        coordinator.AddDocuments(vector<DocumentToAdd>(documents.begin() + half, documents.end()));
+        try {
+            coordinator.AddDocuments(vector<DocumentToAdd>{ { 100'000, "new"s, DocumentStatus::ACTUAL, { 1 } },
+                { 3, "duplicate"s, DocumentStatus::ACTUAL, { 1 } }, { -1, "negative"s, DocumentStatus::ACTUAL, { 1 } } });
+            assert(false);
+        } catch (const AddDocumentsError& error) {
+            [[maybe_unused]] const vector<AddDocumentsError::Failure>& failures = error.GetFailures();
+            assert(failures.size() == 2);
+            assert(failures[0].position == 1 && failures[0].document_id == 3);
+            assert(failures[1].position == 2 && failures[1].document_id == -1);
+        }
+        coordinator.RemoveDocument(100'000);
+        assert(coordinator.GetDocumentCount() == static_cast<int>(documents.size()));
+        for ([[maybe_unused]] const auto& shard : shards) {
+            assert(shard->GetDocumentCount() < coordinator.GetDocumentCount());
+        }
+
+        const auto check_queries = [&](const SearchServer& expected_server) {
+            for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                const vector<vector<Document>> found_batch = coordinator.FindTopDocumentsBatch(queries, status);
+                for (size_t query = 0; query < queries.size(); ++query) {
+                    const vector<Document> expected = expected_server.FindTopDocuments(queries[query], status);
+                    for ([[maybe_unused]] const vector<Document>& found : { coordinator.FindTopDocuments(queries[query], status), found_batch[query] }) {
+                        assert(found.size() == expected.size());
+                        for (size_t i = 0; i < expected.size(); ++i) {
+                            assert(found[i].id == expected[i].id && found[i].rating == expected[i].rating);
+                            assert(abs(found[i].relevance - expected[i].relevance) < 1e-12);
+                        }
+                    }
+                }
+            }
+        };
+        SearchServer expected_server(dictionary[0]);
+        expected_server.AddDocuments(documents);
+        check_queries(expected_server);
+
+        SearchServer reduced_server(dictionary[0]);
+        for (const DocumentToAdd& document : documents) {
+            if (document.id % 2 == 0) {
+                coordinator.RemoveDocument(document.id);
+            } else {
+                reduced_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+        }
+        assert(coordinator.GetDocumentCount() == reduced_server.GetDocumentCount());
+        check_queries(reduced_server);
+        const auto [words, status] = coordinator.MatchDocument(texts[1], 3);
+        const vector<string_view> expected_words = get<0>(reduced_server.MatchDocument(texts[1], 3));
+        assert(vector<string_view>(words.begin(), words.end()) == expected_words && status == DocumentStatus::ACTUAL);
+
+        // ошибки шарда доходят до вызывающего тем же исключением, а соединение остаётся пригодным
+        try {
+            coordinator.RemoveDocument(0);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        try {
+            coordinator.MatchDocument(texts[0], 0);
+            assert(false);
+        } catch (const out_of_range&) {
+        }
+        queries[queries.size() / 2] = "--invalid"s;
+        try {
+            coordinator.FindTopDocumentsBatch(queries);
+            assert(false);
+        } catch (const invalid_argument&) {
+        }
+        assert(coordinator.FindTopDocuments(queries[0]).size() == reduced_server.FindTopDocuments(queries[0]).size());
+
+        coordinator.Shutdown();
+        for (thread& shard_thread : shard_threads) {
+            shard_thread.join();
+        }
+        for ([[maybe_unused]] const string& socket_path : socket_paths) {
+            assert(!filesystem::exists(socket_path));
+        }
+
+        // ответы на большие документы и длинные выдачи больше буфера сокета: пока координатор пишет окно запросов,
+        // шард уже пишет ответы, и ни одна сторона не должна ждать другую
+        {
+            constexpr int LARGE_WORD_COUNT = 1'500;
+            constexpr int LARGE_DOCUMENT_COUNT = static_cast<int>(ShardCoordinator::PIPELINE_DEPTH) * 2;
+            vector<string> large_texts(LARGE_DOCUMENT_COUNT);
+            vector<DocumentToAdd> large_documents;
+            for (int id = 0; id < LARGE_DOCUMENT_COUNT; ++id) {
+                for (int word = 0; word < LARGE_WORD_COUNT; ++word) {
+                    large_texts[id] += "w"s + to_string((id * 37 + word) % (LARGE_WORD_COUNT * 2)) + " "s;
+                }
+                large_documents.push_back({ id, large_texts[id], DocumentStatus::ACTUAL, { id % 7 } });
+            }
+            vector<string> large_queries;
+            for (int query = 0; query < LARGE_DOCUMENT_COUNT; ++query) {
+                large_queries.push_back("w"s + to_string(query) + " w"s + to_string(query * 11 % LARGE_WORD_COUNT));
+            }
+
+            const string socket_path = (filesystem::temp_directory_path() / "search_server_test_large_shard.sock"s).string();
+            SearchServer shard(""s);
+            thread shard_thread(ServeShard, ref(shard), socket_path);
+            ShardCoordinator large_coordinator({ socket_path });
+            large_coordinator.AddDocuments(large_documents);
+            assert(large_coordinator.GetDocumentCount() == LARGE_DOCUMENT_COUNT);
+
+            SearchServer expected_server(""s);
+            expected_server.AddDocuments(large_documents);
+            const vector<vector<Document>> found_batch = large_coordinator.FindTopDocumentsBatch(large_queries,
+                DocumentStatus::ACTUAL, LARGE_DOCUMENT_COUNT);
+            for (size_t query = 0; query < large_queries.size(); ++query) {
+                [[maybe_unused]] const vector<Document> expected = expected_server.FindTopDocuments(large_queries[query],
+                    DocumentStatus::ACTUAL, LARGE_DOCUMENT_COUNT);
+                assert(found_batch[query].size() == expected.size());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    assert(found_batch[query][i].id == expected[i].id);
+                }
+            }
+            large_coordinator.Shutdown();
+            shard_thread.join();
+        }
+        cerr << ">>> TestShardRpc has been passed"sv << endl;
+    }
 } // namespace test
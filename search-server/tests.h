@@ -1,6 +1,11 @@
 #pragma once
 
 #include "search_server.h"
+#include "concurrent_map.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "sharded_search_server.h"
+#include "shard_rpc.h"
 #include "log_duration.h"
 
 #include <execution>
@@ -11,6 +16,9 @@
 #include <vector>
 
 namespace test {
+    // Число вызовов operator new с начала программы
+    size_t GetAllocationCount();
+
     namespace test_policies {
         #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
         std::string GenerateWord(std::mt19937& generator, int max_length);
@@ -38,4 +46,38 @@ namespace test {
     } // namespace test_policies
 
     void TestFind();
+
+    void TestRemoveDocument();
+
+    void TestConcurrentMap();
+
+    void TestQueryCache();
+
+    void TestProcessQueries();
+
+    void TestPostingListFormats();
+
+    void TestSnapshot();
+
+    void TestAddDocuments();
+
+    void TestConcurrentSearchServer();
+
+    void TestSegments();
+
+    void TestRemoveDuplicates();
+
+    void TestSplitIntoWords();
+
+    void TestQueryContext();
+
+    void TestInverseDocumentFreqCache();
+    void TestDynamicPruning();
+    void TestRequiredWords();
+    void TestStatusPartitions();
+    void TestMatchDocuments();
+    void TestRemoveDocuments();
+    void TestDocumentIdOrder();
+    void TestShardedSearchServer();
+    void TestShardRpc();
 } // namespace test
@@ -0,0 +1,87 @@
+#pragma once
+#include "document.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <iterator>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Оставляет в documents не более count лучших документов, упорядоченных компаратором.
+// Вместо полной сортировки выполняется частичная: O(n * log(count))
+template <typename Comparator>
+void SelectTopDocuments(std::execution::sequenced_policy, std::vector<Document>& documents, size_t count,
+    Comparator comparator) {
+    if (documents.size() > count) {
+        std::partial_sort(documents.begin(), documents.begin() + count, documents.end(), comparator);
+        documents.resize(count);
+    } else {
+        std::sort(documents.begin(), documents.end(), comparator);
+    }
+}
+
+// Каждый поток выбирает лучшие документы своего участка, затем кандидаты всех участков сливаются
+template <typename Comparator>
+void SelectTopDocuments(std::execution::parallel_policy policy, std::vector<Document>& documents, size_t count,
+    Comparator comparator) {
+    // на небольших объёмах накладные расходы на потоки больше выигрыша
+    constexpr size_t MIN_CHUNK_SIZE = 4096;
+    const size_t chunk_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+        documents.size() / std::max(MIN_CHUNK_SIZE, count));
+    if (chunk_count < 2) {
+        SelectTopDocuments(std::execution::seq, documents, count, comparator);
+        return;
+    }
+    const size_t chunk_size = (documents.size() + chunk_count - 1) / chunk_count;
+    std::vector<size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    std::for_each(policy, chunks.begin(), chunks.end(), [&](size_t chunk) {
+        const auto chunk_begin = documents.begin() + chunk * chunk_size;
+        const auto chunk_end = documents.begin() + std::min(documents.size(), (chunk + 1) * chunk_size);
+        if (static_cast<size_t>(std::distance(chunk_begin, chunk_end)) > count) {
+            std::nth_element(chunk_begin, chunk_begin + count, chunk_end, comparator);
+        }
+    });
+    // лучшие документы каждого участка переносятся в его начало, остальное отбрасывается
+    size_t candidate_count = 0;
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const size_t chunk_begin = chunk * chunk_size;
+        const size_t chunk_top = std::min({ count, chunk_size, documents.size() - chunk_begin });
+        std::move(documents.begin() + chunk_begin, documents.begin() + chunk_begin + chunk_top,
+            documents.begin() + candidate_count);
+        candidate_count += chunk_top;
+    }
+    documents.resize(candidate_count);
+    SelectTopDocuments(std::execution::seq, documents, count, comparator);
+}
+
+// Сливает списки документов, каждый из которых упорядочен компаратором, в не более чем count лучших
+template <typename Comparator>
+std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& document_lists, size_t count,
+    Comparator comparator) {
+    // в куче - номер списка и позиция его лучшего ещё не взятого документа
+    using Head = std::pair<size_t, size_t>;
+    const auto is_worse = [&](const Head& lhs, const Head& rhs) {
+        return comparator(document_lists[rhs.first][rhs.second], document_lists[lhs.first][lhs.second]);
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(is_worse)> heads(is_worse);
+    for (size_t list = 0; list < document_lists.size(); ++list) {
+        if (!document_lists[list].empty()) {
+            heads.push({ list, 0 });
+        }
+    }
+    std::vector<Document> documents;
+    while (documents.size() < count && !heads.empty()) {
+        const auto [list, position] = heads.top();
+        heads.pop();
+        documents.push_back(document_lists[list][position]);
+        if (position + 1 < document_lists[list].size()) {
+            heads.push({ list, position + 1 });
+        }
+    }
+    return documents;
+}